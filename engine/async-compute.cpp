@@ -0,0 +1,170 @@
+#include "async-compute.hpp"
+
+#include "logger.hpp"
+
+#include "vk/buffers.hpp"
+#include "vk/device/device.hpp"
+
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+auto AsyncCompute::create(vk::Device &device, vk::QueueFamily &computeFamily,
+                          uint32_t graphicsFamily, uint32_t framesInFlight,
+                          uint32_t queueIndex) -> std::optional<AsyncCompute> {
+  if (!computeFamily.isCompute()) {
+    Logger::error("Queue family {} does not support compute",
+                  computeFamily.getIndex());
+    return std::nullopt;
+  }
+
+  if (framesInFlight == 0) {
+    Logger::error("Async compute needs at least one frame in flight");
+    return std::nullopt;
+  }
+
+  auto queue = device.getQueue(computeFamily, queueIndex);
+  if (!queue.has_value()) {
+    Logger::error("Failed to get compute queue");
+    return std::nullopt;
+  }
+
+  auto poolInfo = vk::info::CommandPoolCreate(computeFamily, true);
+  auto pool = device.createCommandPool(poolInfo);
+  if (!pool.has_value()) {
+    Logger::error("Failed to create compute command pool");
+    return std::nullopt;
+  }
+
+  auto commandBuffers = pool->allocBuffers(framesInFlight);
+  if (!commandBuffers.has_value()) {
+    return std::nullopt;
+  }
+
+  auto timeline = vk::QueueTimeline::create(device);
+  if (!timeline.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<Frame> frames;
+  frames.reserve(framesInFlight);
+  for (auto &commandBuffer : commandBuffers.value()) {
+    frames.push_back({.commandBuffer = commandBuffer});
+  }
+
+  return AsyncCompute(queue.value(), graphicsFamily, std::move(pool.value()),
+                      std::move(timeline.value()), std::move(frames));
+}
+
+auto AsyncCompute::begin(uint64_t frameNumber) -> vk::CommandBuffer::Encoder {
+  m_current = static_cast<uint32_t>(frameNumber % m_frames.size());
+  auto &frame = m_frames[m_current];
+
+  // Value 0 is the initial value, so unused slots do not wait
+  if (!m_timeline.wait(frame.value)) {
+    Logger::error("Failed to wait for compute frame {}", m_current);
+  }
+  frame.submitted = false;
+
+  frame.commandBuffer.reset();
+  return frame.commandBuffer.begin(vk::info::CommandBufferBegin().oneTime());
+}
+
+void AsyncCompute::releaseBuffer(vk::CommandBuffer::Encoder &encoder,
+                                 vk::Buffer &buffer, vk::BarrierScope src,
+                                 vk::BarrierScope dst, VkDeviceSize offset,
+                                 VkDeviceSize size) {
+  if (!isDedicated()) {
+    // Same family, the semaphore wait already orders and makes visible all
+    // compute writes
+    return;
+  }
+
+  encoder.barriers().buffer(*buffer, src, {}, offset, size,
+                            m_queue.getFamilyIndex(), m_graphicsFamily);
+  m_bufferAcquires.push_back(
+      {.buffer = *buffer, .dst = dst, .offset = offset, .size = size});
+}
+
+void AsyncCompute::releaseImage(vk::CommandBuffer::Encoder &encoder,
+                                VkImage image, VkImageLayout oldLayout,
+                                VkImageLayout newLayout, vk::BarrierScope src,
+                                vk::BarrierScope dst,
+                                const VkImageSubresourceRange &range) {
+  if (!isDedicated()) {
+    if (oldLayout != newLayout) {
+      encoder.barriers().image(image, oldLayout, newLayout, src, dst, range);
+    }
+    return;
+  }
+
+  encoder.barriers().image(image, oldLayout, newLayout, src, {}, range,
+                           m_queue.getFamilyIndex(), m_graphicsFamily);
+  m_imageAcquires.push_back({.image = image,
+                             .oldLayout = oldLayout,
+                             .newLayout = newLayout,
+                             .dst = dst,
+                             .range = range});
+}
+
+auto AsyncCompute::submit(vk::CommandBuffer::Encoder &encoder) -> bool {
+  auto &frame = m_frames[m_current];
+
+  auto result = encoder.end();
+  if (result != VK_SUCCESS) {
+    Logger::error("Failed to end compute command buffer: {}",
+                  static_cast<int>(result));
+    return false;
+  }
+
+  vk::info::Submit submitInfo;
+  submitInfo.addCommandBuffer(frame.commandBuffer);
+  auto value = m_timeline.next();
+  m_timeline.addSignal(submitInfo, value);
+
+  auto error = m_queue.submit(submitInfo);
+  if (error.has_value()) {
+    Logger::error("Failed to submit compute work: {}",
+                  static_cast<int>(static_cast<VkResult>(error.value())));
+
+    // The releases never ran, so there is nothing to acquire or wait for
+    m_bufferAcquires.clear();
+    m_imageAcquires.clear();
+    return false;
+  }
+
+  m_timeline.commit(value);
+  frame.value = value;
+  frame.submitted = true;
+  return true;
+}
+
+void AsyncCompute::addDependency(vk::info::Submit &graphicsSubmit,
+                                 VkPipelineStageFlags stages) {
+  auto &frame = m_frames[m_current];
+  if (!frame.submitted) {
+    return;
+  }
+
+  m_timeline.addWait(graphicsSubmit, frame.value, stages);
+}
+
+void AsyncCompute::acquire(vk::CommandBuffer::Encoder &graphics) {
+  for (const auto &acquire : m_bufferAcquires) {
+    graphics.barriers().buffer(acquire.buffer, {}, acquire.dst,
+                               acquire.offset, acquire.size,
+                               m_queue.getFamilyIndex(), m_graphicsFamily);
+  }
+
+  for (const auto &acquire : m_imageAcquires) {
+    graphics.barriers().image(acquire.image, acquire.oldLayout,
+                              acquire.newLayout, {}, acquire.dst,
+                              acquire.range, m_queue.getFamilyIndex(),
+                              m_graphicsFamily);
+  }
+
+  m_bufferAcquires.clear();
+  m_imageAcquires.clear();
+}
+} // namespace engine
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "vk/commands/buffer.hpp"
+#include "vk/commands/pool.hpp"
+#include "vk/queue.hpp"
+#include "vk/sync/barrier.hpp"
+#include "vk/sync/timeline.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+class Device;
+class Buffer;
+} // namespace vk
+
+namespace engine {
+// Runs compute work on its own queue so it overlaps with the graphics work of
+// the same frame.
+//
+// Each frame in flight owns a command buffer, and every compute submit
+// signals the next value of the queue's timeline. Graphics submits wait for
+// that value through `addDependency`, and `begin` waits for the value a slot
+// last signalled before reusing it.
+//
+// When the compute family differs from the graphics family, resources
+// produced by compute are handed over with `releaseBuffer` / `releaseImage`,
+// which record the release half of a queue family ownership transfer and
+// queue the matching acquire for `acquire` on the graphics side. Resources
+// written every frame should be duplicated per frame in flight, as nothing
+// orders the next frame's compute writes after this frame's graphics reads.
+class AsyncCompute {
+  struct Frame {
+    vk::CommandBuffer commandBuffer;
+    // Timeline value signalled by the last submit of this slot
+    uint64_t value = 0;
+    bool submitted = false;
+  };
+
+  struct BufferAcquire {
+    VkBuffer buffer;
+    vk::BarrierScope dst;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+  };
+
+  struct ImageAcquire {
+    VkImage image;
+    VkImageLayout oldLayout;
+    VkImageLayout newLayout;
+    vk::BarrierScope dst;
+    VkImageSubresourceRange range;
+  };
+
+  vk::Queue m_queue;
+  uint32_t m_graphicsFamily;
+  vk::CommandPool m_pool;
+  vk::QueueTimeline m_timeline;
+  std::vector<Frame> m_frames;
+  uint32_t m_current = 0;
+
+  std::vector<BufferAcquire> m_bufferAcquires;
+  std::vector<ImageAcquire> m_imageAcquires;
+
+  AsyncCompute(vk::Queue queue, uint32_t graphicsFamily, vk::CommandPool &&pool,
+               vk::QueueTimeline &&timeline, std::vector<Frame> &&frames)
+      : m_queue(queue), m_graphicsFamily(graphicsFamily),
+        m_pool(std::move(pool)), m_timeline(std::move(timeline)),
+        m_frames(std::move(frames)) {}
+
+public:
+  // `computeFamily` is usually `QueueFamilies::getCompute()`. The device must
+  // have been created with a queue of that family at `queueIndex`.
+  static auto create(vk::Device &device, vk::QueueFamily &computeFamily,
+                     uint32_t graphicsFamily, uint32_t framesInFlight,
+                     uint32_t queueIndex = 0) -> std::optional<AsyncCompute>;
+
+  AsyncCompute(AsyncCompute &&other) noexcept = default;
+
+  // Whether ownership transfers are needed, i.e. compute runs on a different
+  // queue family than graphics
+  [[nodiscard]] auto isDedicated() const -> bool {
+    return m_queue.getFamilyIndex() != m_graphicsFamily;
+  }
+
+  [[nodiscard]] auto queue() -> vk::Queue & { return m_queue; }
+
+  [[nodiscard]] auto timeline() const -> const vk::QueueTimeline & {
+    return m_timeline;
+  }
+
+  // Wait for slot `frameNumber % framesInFlight` to finish on the GPU and
+  // start recording its command buffer.
+  auto begin(uint64_t frameNumber) -> vk::CommandBuffer::Encoder;
+
+  // Release `buffer` from compute to graphics after the compute accesses in
+  // `src`. Graphics acquires it for `dst` in `acquire`.
+  void releaseBuffer(vk::CommandBuffer::Encoder &encoder, vk::Buffer &buffer,
+                     vk::BarrierScope src, vk::BarrierScope dst,
+                     VkDeviceSize offset = 0,
+                     VkDeviceSize size = VK_WHOLE_SIZE);
+
+  // The layout transition is performed once, as part of the transfer
+  void releaseImage(vk::CommandBuffer::Encoder &encoder, VkImage image,
+                    VkImageLayout oldLayout, VkImageLayout newLayout,
+                    vk::BarrierScope src, vk::BarrierScope dst,
+                    const VkImageSubresourceRange &range);
+
+  // End and submit the frame's compute work, signalling the next timeline
+  // value
+  auto submit(vk::CommandBuffer::Encoder &encoder) -> bool;
+
+  // Make a graphics submit wait for this frame's compute work at `stages`.
+  // Does nothing if no compute work was submitted this frame.
+  void addDependency(vk::info::Submit &graphicsSubmit,
+                     VkPipelineStageFlags stages);
+
+  // Queue the acquire half of every pending ownership transfer on the
+  // graphics encoder. Must be recorded in the command buffer submitted with
+  // the dependency, before the resources are used.
+  void acquire(vk::CommandBuffer::Encoder &graphics);
+};
+} // namespace engine
@@ -0,0 +1,168 @@
+#include "draw-list.hpp"
+
+#include <array>
+#include <barrier>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace engine {
+namespace {
+constexpr uint32_t RadixBits = 8;
+constexpr uint32_t Buckets = 1u << RadixBits;
+constexpr uint32_t Passes = 64 / RadixBits;
+
+// Below this the cost of waking threads outweighs the histogram work
+constexpr size_t ParallelThreshold = 1u << 14;
+
+using Histogram = std::array<size_t, Buckets>;
+
+constexpr auto digit(uint64_t key, uint32_t pass) -> uint32_t {
+  return static_cast<uint32_t>(key >> (pass * RadixBits)) & (Buckets - 1);
+}
+
+// Bit mask of the passes whose digit differs between at least two keys
+auto activePasses(const std::vector<SortEntry> &entries) -> uint32_t {
+  uint64_t first = entries.front().key;
+  uint64_t diff = 0;
+  for (const auto &entry : entries) {
+    diff |= entry.key ^ first;
+  }
+
+  uint32_t mask = 0;
+  for (uint32_t pass = 0; pass < Passes; pass++) {
+    if (digit(diff, pass) != 0) {
+      mask |= 1u << pass;
+    }
+  }
+  return mask;
+}
+
+void sortSerial(std::vector<SortEntry> &entries, uint32_t passes) {
+  std::vector<SortEntry> scratch(entries.size());
+  auto *src = &entries;
+  auto *dst = &scratch;
+
+  for (uint32_t pass = 0; pass < Passes; pass++) {
+    if ((passes & (1u << pass)) == 0) {
+      continue;
+    }
+
+    Histogram offsets{};
+    for (const auto &entry : *src) {
+      offsets[digit(entry.key, pass)]++;
+    }
+
+    size_t sum = 0;
+    for (auto &offset : offsets) {
+      auto count = offset;
+      offset = sum;
+      sum += count;
+    }
+
+    for (const auto &entry : *src) {
+      (*dst)[offsets[digit(entry.key, pass)]++] = entry;
+    }
+
+    std::swap(src, dst);
+  }
+
+  if (src != &entries) {
+    entries.swap(scratch);
+  }
+}
+
+void sortParallel(std::vector<SortEntry> &entries, uint32_t passes,
+                  uint32_t threadCount) {
+  std::vector<SortEntry> scratch(entries.size());
+  std::vector<Histogram> histograms(threadCount);
+
+  std::vector<uint32_t> activeList;
+  for (uint32_t pass = 0; pass < Passes; pass++) {
+    if ((passes & (1u << pass)) != 0) {
+      activeList.push_back(pass);
+    }
+  }
+
+  const size_t chunk = (entries.size() + threadCount - 1) / threadCount;
+
+  // Turn the per-thread histograms into per-thread scatter offsets. Buckets are
+  // laid out in digit order and, within a bucket, in thread order so each
+  // thread writes a disjoint range and the sort stays stable.
+  auto prefixSum = [&histograms, threadCount]() noexcept {
+    size_t sum = 0;
+    for (uint32_t bucket = 0; bucket < Buckets; bucket++) {
+      for (uint32_t t = 0; t < threadCount; t++) {
+        auto count = histograms[t][bucket];
+        histograms[t][bucket] = sum;
+        sum += count;
+      }
+    }
+  };
+
+  std::barrier histogramsDone(threadCount, prefixSum);
+  std::barrier scatterDone(threadCount);
+
+  auto worker = [&](uint32_t t) {
+    size_t begin = std::min(entries.size(), t * chunk);
+    size_t end = std::min(entries.size(), begin + chunk);
+
+    auto *src = &entries;
+    auto *dst = &scratch;
+
+    for (auto pass : activeList) {
+      auto &histogram = histograms[t];
+      histogram.fill(0);
+      for (size_t i = begin; i < end; i++) {
+        histogram[digit((*src)[i].key, pass)]++;
+      }
+
+      histogramsDone.arrive_and_wait();
+
+      for (size_t i = begin; i < end; i++) {
+        const auto &entry = (*src)[i];
+        (*dst)[histogram[digit(entry.key, pass)]++] = entry;
+      }
+
+      scatterDone.arrive_and_wait();
+      std::swap(src, dst);
+    }
+  };
+
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(threadCount - 1);
+    for (uint32_t t = 1; t < threadCount; t++) {
+      threads.emplace_back(worker, t);
+    }
+    worker(0);
+  }
+
+  if (activeList.size() % 2 != 0) {
+    entries.swap(scratch);
+  }
+}
+} // namespace
+
+void radixSort(std::vector<SortEntry> &entries, uint32_t threadCount) {
+  if (entries.size() < 2) {
+    return;
+  }
+
+  auto passes = activePasses(entries);
+  if (passes == 0) {
+    return;
+  }
+
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  if (threadCount == 1 || entries.size() < ParallelThreshold) {
+    sortSerial(entries, passes);
+    return;
+  }
+
+  sortParallel(entries, passes, threadCount);
+}
+} // namespace engine
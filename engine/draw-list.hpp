@@ -0,0 +1,245 @@
+#pragma once
+
+#include "vk/buffers.hpp"
+#include "vk/descriptors.hpp"
+#include "vk/pipeline/pipeline.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace engine {
+// Packed per-draw sort key. From most to least significant bits:
+// pass (4) | pipeline (12) | material (12) | mesh (12) | depth (24)
+//
+// Sorting by the key groups draws by pass first, then by pipeline and
+// descriptor state, so consecutive draws share as much bound state as
+// possible.
+class DrawKey {
+  uint64_t m_key;
+
+public:
+  static constexpr uint32_t PassBits = 4;
+  static constexpr uint32_t PipelineBits = 12;
+  static constexpr uint32_t MaterialBits = 12;
+  static constexpr uint32_t MeshBits = 12;
+  static constexpr uint32_t DepthBits = 24;
+
+  static constexpr uint32_t DepthShift = 0;
+  static constexpr uint32_t MeshShift = DepthShift + DepthBits;
+  static constexpr uint32_t MaterialShift = MeshShift + MeshBits;
+  static constexpr uint32_t PipelineShift = MaterialShift + MaterialBits;
+  static constexpr uint32_t PassShift = PipelineShift + PipelineBits;
+
+  static_assert(PassShift + PassBits == 64);
+
+  constexpr explicit DrawKey(uint64_t key = 0) : m_key(key) {}
+
+  // Depth is expected to be normalized to [0, 1]. Opaque geometry sorts front
+  // to back, transparent geometry should pass `backToFront`.
+  static constexpr auto pack(uint32_t pass, uint32_t pipeline,
+                             uint32_t material, uint32_t mesh, float depth,
+                             bool backToFront = false) -> DrawKey {
+    constexpr uint32_t maxDepth = (1u << DepthBits) - 1;
+    auto quantized =
+        static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * maxDepth);
+    if (backToFront) {
+      quantized = maxDepth - quantized;
+    }
+
+    return DrawKey(field(pass, PassBits, PassShift) |
+                   field(pipeline, PipelineBits, PipelineShift) |
+                   field(material, MaterialBits, MaterialShift) |
+                   field(mesh, MeshBits, MeshShift) |
+                   field(quantized, DepthBits, DepthShift));
+  }
+
+  [[nodiscard]] constexpr auto pass() const -> uint32_t {
+    return extract(PassBits, PassShift);
+  }
+  [[nodiscard]] constexpr auto pipeline() const -> uint32_t {
+    return extract(PipelineBits, PipelineShift);
+  }
+  [[nodiscard]] constexpr auto material() const -> uint32_t {
+    return extract(MaterialBits, MaterialShift);
+  }
+  [[nodiscard]] constexpr auto mesh() const -> uint32_t {
+    return extract(MeshBits, MeshShift);
+  }
+  [[nodiscard]] constexpr auto depth() const -> uint32_t {
+    return extract(DepthBits, DepthShift);
+  }
+
+  constexpr operator uint64_t() const { return m_key; }
+
+private:
+  static constexpr auto field(uint32_t value, uint32_t bits, uint32_t shift)
+      -> uint64_t {
+    return (static_cast<uint64_t>(value) & ((1ull << bits) - 1)) << shift;
+  }
+
+  [[nodiscard]] constexpr auto extract(uint32_t bits, uint32_t shift) const
+      -> uint32_t {
+    return static_cast<uint32_t>((m_key >> shift) & ((1ull << bits) - 1));
+  }
+};
+
+struct Draw {
+  const vk::Pipeline *pipeline = nullptr;
+  const vk::DescriptorSet *descriptorSet = nullptr;
+  vk::VertexBuffer *vertexBuffer = nullptr;
+  // When set the draw is emitted with drawIndexed
+  vk::IndexBuffer *indexBuffer = nullptr;
+
+  // Vertex count for plain draws, index count for indexed draws
+  uint32_t count = 0;
+  uint32_t instanceCount = 1;
+  // First vertex for plain draws, first index for indexed draws
+  uint32_t first = 0;
+  int32_t vertexOffset = 0;
+  uint32_t firstInstance = 0;
+};
+
+struct SortEntry {
+  uint64_t key;
+  uint32_t index;
+};
+
+// Stable LSD radix sort on the 64 bit keys, 8 bits per pass. Passes where every
+// key shares the same digit are skipped. `threadCount` of 0 uses the hardware
+// concurrency; small inputs are always sorted on the calling thread.
+void radixSort(std::vector<SortEntry> &entries, uint32_t threadCount = 0);
+
+class DrawList {
+  std::vector<Draw> m_draws;
+  std::vector<SortEntry> m_order;
+  bool m_sorted = true;
+
+public:
+  struct EmitStats {
+    uint32_t draws = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorSetBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+  };
+
+  auto add(DrawKey key, const Draw &draw) -> void {
+    m_order.push_back(
+        {.key = key, .index = static_cast<uint32_t>(m_draws.size())});
+    m_draws.push_back(draw);
+    m_sorted = false;
+  }
+
+  auto reserve(size_t count) -> void {
+    m_draws.reserve(count);
+    m_order.reserve(count);
+  }
+
+  auto clear() -> void {
+    m_draws.clear();
+    m_order.clear();
+    m_sorted = true;
+  }
+
+  [[nodiscard]] auto size() const -> size_t { return m_draws.size(); }
+  [[nodiscard]] auto empty() const -> bool { return m_draws.empty(); }
+
+  // Sorted (key, draw index) pairs, valid after `sort`
+  [[nodiscard]] auto order() const -> std::span<const SortEntry> {
+    return m_order;
+  }
+
+  auto sort(uint32_t threadCount = 0) -> void {
+    if (m_sorted) {
+      return;
+    }
+    radixSort(m_order, threadCount);
+    m_sorted = true;
+  }
+
+  // Sorted entries whose key has `pass` as its pass field
+  auto passRange(uint32_t pass) -> std::span<const SortEntry> {
+    sort();
+
+    auto first = DrawKey::pack(pass, 0, 0, 0, 0.0f);
+    auto byPass = [](uint64_t a, uint64_t b) {
+      return (a >> DrawKey::PassShift) < (b >> DrawKey::PassShift);
+    };
+    auto [begin, end] = std::ranges::equal_range(
+        m_order, static_cast<uint64_t>(first), byPass, &SortEntry::key);
+    return {begin, end};
+  }
+
+  // Emit every draw in key order, only binding state that differs from the
+  // previous draw. All passes go to `sink`, so use this when the pass field
+  // only orders draws within one render pass, e.g. opaque then transparent.
+  // `Sink` is anything with the `Encoder::RenderPass` draw API, e.g. a render
+  // pass or a `vk::CommandStream`.
+  template <typename Sink> auto emit(Sink &sink) -> EmitStats {
+    sort();
+    return emitRange(m_order, sink);
+  }
+
+  // Emit only the draws of `pass`, for recording each pass into its own
+  // render pass
+  template <typename Sink> auto emit(uint32_t pass, Sink &sink) -> EmitStats {
+    return emitRange(passRange(pass), sink);
+  }
+
+private:
+  template <typename Sink>
+  auto emitRange(std::span<const SortEntry> entries, Sink &sink)
+      -> EmitStats {
+    EmitStats stats{};
+
+    const vk::Pipeline *pipeline = nullptr;
+    const vk::DescriptorSet *descriptorSet = nullptr;
+    vk::VertexBuffer *vertexBuffer = nullptr;
+    vk::IndexBuffer *indexBuffer = nullptr;
+
+    for (const auto &entry : entries) {
+      auto &draw = m_draws[entry.index];
+
+      if (draw.pipeline != pipeline && draw.pipeline != nullptr) {
+        pipeline = draw.pipeline;
+        sink.bindPipeline(*pipeline);
+        stats.pipelineBinds++;
+        // Set bindings are not guaranteed to survive incompatible layouts
+        descriptorSet = nullptr;
+      }
+
+      if (draw.descriptorSet != descriptorSet &&
+          draw.descriptorSet != nullptr) {
+        descriptorSet = draw.descriptorSet;
+        sink.bindDescriptorSet(*descriptorSet);
+        stats.descriptorSetBinds++;
+      }
+
+      if (draw.vertexBuffer != vertexBuffer && draw.vertexBuffer != nullptr) {
+        vertexBuffer = draw.vertexBuffer;
+        sink.bindVertexBuffer(0, *vertexBuffer);
+        stats.vertexBufferBinds++;
+      }
+
+      if (draw.indexBuffer != nullptr) {
+        if (draw.indexBuffer != indexBuffer) {
+          indexBuffer = draw.indexBuffer;
+          sink.bindIndexBuffer(*indexBuffer);
+          stats.indexBufferBinds++;
+        }
+
+        sink.drawIndexed(draw.count, draw.instanceCount, draw.first,
+                         draw.vertexOffset, draw.firstInstance);
+      } else {
+        sink.draw(draw.count, draw.instanceCount, draw.first,
+                  draw.firstInstance);
+      }
+      stats.draws++;
+    }
+
+    return stats;
+  }
+};
+} // namespace engine
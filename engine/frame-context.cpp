@@ -0,0 +1,350 @@
+#include "frame-context.hpp"
+
+#include "logger.hpp"
+
+#include "vk/device/device.hpp"
+#include "vk/enums/memory-properties.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+auto TransientBuffer::create(vk::Device &device, VkDeviceSize size)
+    -> std::optional<TransientBuffer> {
+  auto bufferInfo = vk::info::BufferCreate(
+      vk::Size(size), vk::BufferUsage::UniformBuffer |
+                          vk::BufferUsage::StorageBuffer |
+                          vk::BufferUsage::VertexBuffer |
+                          vk::BufferUsage::IndexBuffer);
+  auto buffer = device.createBuffer(bufferInfo);
+  if (!buffer.has_value()) {
+    Logger::error("Failed to create transient buffer");
+    return std::nullopt;
+  }
+
+  auto memory = device.allocateMemory(buffer.value(),
+                                      vk::MemoryProperties::HostVisible |
+                                          vk::MemoryProperties::HostCoherent);
+  if (!memory.has_value()) {
+    Logger::error("Failed to allocate transient buffer memory");
+    return std::nullopt;
+  }
+
+  if (buffer->bind(memory.value()).has_value()) {
+    Logger::error("Failed to bind transient buffer memory");
+    return std::nullopt;
+  }
+
+  auto mapping = memory->map();
+  if (!mapping.has_value()) {
+    Logger::error("Failed to map transient buffer memory");
+    return std::nullopt;
+  }
+
+  return TransientBuffer(std::move(buffer.value()), std::move(memory.value()),
+                         std::move(mapping.value()));
+}
+
+auto TransientBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment)
+    -> std::optional<Allocation> {
+  VkDeviceSize offset = (m_used + alignment - 1) & ~(alignment - 1);
+  if (offset + size > m_mapping.getSize()) {
+    return std::nullopt;
+  }
+
+  m_used = offset + size;
+  return Allocation{
+      .buffer = m_buffer,
+      .offset = offset,
+      .data = static_cast<std::byte *>(m_mapping.get()) + offset,
+  };
+}
+
+auto FrameRing::create(vk::Device &device, vk::QueueFamily &graphicsFamily,
+                       vk::Queue graphics, vk::PresentQueue present,
+                       vk::PresentTarget &target, uint32_t framesInFlight,
+                       VkDeviceSize transientSize)
+    -> std::optional<FrameRing> {
+  if (framesInFlight == 0) {
+    Logger::error("Frame ring needs at least one frame in flight");
+    return std::nullopt;
+  }
+
+  std::vector<std::unique_ptr<FrameContext>> frames;
+  frames.reserve(framesInFlight);
+  for (uint32_t i = 0; i < framesInFlight; i++) {
+    // Transient since every buffer is re-recorded each time the frame comes
+    // around, and reset as a whole through the pool
+    auto poolInfo = vk::info::CommandPoolCreate(graphicsFamily, false, true);
+    auto pool = device.createCommandPool(poolInfo);
+    if (!pool.has_value()) {
+      Logger::error("Failed to create frame command pool");
+      return std::nullopt;
+    }
+
+    auto commandBuffer = pool->allocBuffer();
+    if (!commandBuffer.has_value()) {
+      Logger::error("Failed to allocate frame command buffer");
+      return std::nullopt;
+    }
+
+    // Signalled so the first wait on every frame returns immediately
+    auto fence = device.createFence(true);
+    if (!fence.has_value()) {
+      Logger::error("Failed to create frame fence");
+      return std::nullopt;
+    }
+
+    auto imageAcquired = device.createSemaphore();
+    if (!imageAcquired.has_value()) {
+      Logger::error("Failed to create image acquired semaphore");
+      return std::nullopt;
+    }
+
+    auto transient = TransientBuffer::create(device, transientSize);
+    if (!transient.has_value()) {
+      return std::nullopt;
+    }
+
+    frames.push_back(std::make_unique<FrameContext>(FrameContext{
+        .pool = std::move(pool.value()),
+        .commandBuffer = std::move(commandBuffer.value()),
+        .fence = std::move(fence.value()),
+        .imageAcquired = std::move(imageAcquired.value()),
+        .transient = std::move(transient.value()),
+    }));
+  }
+
+  return FrameRing(graphics, std::move(present), target, std::move(frames));
+}
+
+namespace {
+// Presents measured before giving up on older ones, in case the driver
+// never reports them
+constexpr size_t MaxPendingPresents = 16;
+
+// Longest the throttle waits for a present, in case it never happens
+constexpr uint64_t ThrottleTimeoutNs = 100'000'000;
+} // namespace
+
+void FrameRing::setTarget(vk::PresentTarget &target) {
+  m_target = &target;
+  m_firstPresentId = m_frameNumber + 1;
+  m_pendingPresents.clear();
+}
+
+void FrameRing::recordPresentLatency(std::chrono::nanoseconds latency) {
+  std::chrono::duration<double, std::milli> ms = latency;
+  m_stats.lastPresentLatencyMs = ms.count();
+  m_stats.averagePresentLatencyMs =
+      m_stats.presentsMeasured == 0
+          ? m_stats.lastPresentLatencyMs
+          : m_stats.averagePresentLatencyMs * 0.95 +
+                m_stats.lastPresentLatencyMs * 0.05;
+  m_stats.presentsMeasured++;
+}
+
+void FrameRing::collectPresentTimings() {
+  if (m_target->supportsDisplayTiming()) {
+    // Ids are truncated to 32 bits, so compare them as a wrapping distance.
+    // Negative means the timing is for a present before the front one.
+    auto distance = [](const PendingPresent &present, uint32_t id) {
+      return static_cast<int32_t>(id - static_cast<uint32_t>(present.id));
+    };
+
+    for (const auto &timing : m_target->pastPresentationTimings()) {
+      // Presents before the reported one were skipped by the display
+      while (!m_pendingPresents.empty() &&
+             distance(m_pendingPresents.front(), timing.presentID) > 0) {
+        m_pendingPresents.pop_front();
+      }
+
+      // Already trimmed, or presented to an earlier target
+      if (m_pendingPresents.empty() ||
+          distance(m_pendingPresents.front(), timing.presentID) != 0) {
+        continue;
+      }
+
+      // Display timing reports CLOCK_MONOTONIC, the clock behind
+      // steady_clock on Linux
+      auto submitted = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          m_pendingPresents.front().submitted.time_since_epoch());
+      auto presented = std::chrono::nanoseconds(timing.actualPresentTime);
+      recordPresentLatency(presented - submitted);
+      m_pendingPresents.pop_front();
+    }
+  } else if (m_target->supportsPresentWait()) {
+    // Only as precise as the frame rate, the display time is when the poll
+    // first sees the present
+    while (!m_pendingPresents.empty() &&
+           m_target->waitForPresent(m_pendingPresents.front().id, 0) ==
+               VK_SUCCESS) {
+      recordPresentLatency(std::chrono::steady_clock::now() -
+                           m_pendingPresents.front().submitted);
+      m_pendingPresents.pop_front();
+    }
+  }
+
+  while (m_pendingPresents.size() > MaxPendingPresents) {
+    m_pendingPresents.pop_front();
+  }
+}
+
+auto FrameRing::beginFrame() -> FrameContext * {
+  if (m_current != nullptr) {
+    Logger::error("beginFrame called twice without endFrame");
+    return nullptr;
+  }
+
+  if (m_presentTiming) {
+    // Id of the frame before the previous one
+    uint64_t throttleId = m_frameNumber - 1;
+    if (m_throttle && m_target->supportsPresentWait() &&
+        m_frameNumber >= 2 && throttleId >= m_firstPresentId) {
+      auto start = std::chrono::steady_clock::now();
+      auto result = m_target->waitForPresent(throttleId, ThrottleTimeoutNs);
+      std::chrono::duration<double, std::milli> waited =
+          std::chrono::steady_clock::now() - start;
+      m_stats.lastThrottleMs = waited.count();
+
+      // The present was lost, stop measuring it and everything before it
+      if (result != VK_SUCCESS) {
+        std::erase_if(m_pendingPresents, [&](const PendingPresent &present) {
+          return present.id <= throttleId;
+        });
+      }
+    }
+
+    collectPresentTimings();
+  }
+
+  auto &frame = *m_frames[m_frameNumber % m_frames.size()];
+
+  auto start = std::chrono::steady_clock::now();
+  frame.fence.wait();
+  std::chrono::duration<double, std::milli> waited =
+      std::chrono::steady_clock::now() - start;
+
+  m_stats.lastWaitMs = waited.count();
+  m_stats.averageWaitMs = m_stats.frames == 0
+                              ? m_stats.lastWaitMs
+                              : m_stats.averageWaitMs * 0.95 +
+                                    m_stats.lastWaitMs * 0.05;
+  m_stats.maxWaitMs = std::max(m_stats.maxWaitMs, m_stats.lastWaitMs);
+  m_stats.frames++;
+
+  // Frames complete in submission order, so everything up to the frame that
+  // last used this slot is done
+  if (m_frameNumber >= m_frames.size()) {
+    m_deletions.collect(m_frameNumber - m_frames.size());
+  }
+
+  // The fence is only reset right before submitting, so a failed acquire
+  // leaves the frame signalled and reusable
+  auto image = m_target->acquire(frame.imageAcquired);
+  if (image.state == VK_ERROR_OUT_OF_DATE_KHR) {
+    return nullptr;
+  }
+
+  if (image.state != VK_SUCCESS && image.state != VK_SUBOPTIMAL_KHR) {
+    Logger::error("Failed to acquire image: {}", static_cast<int>(image.state));
+    return nullptr;
+  }
+
+  auto reset = frame.pool.reset();
+  if (reset != VK_SUCCESS) {
+    Logger::error("Failed to reset frame command pool: {}",
+                  static_cast<int>(reset));
+    abandonFrame(frame);
+    return nullptr;
+  }
+
+  frame.transient.reset();
+  frame.frameNumber = m_frameNumber;
+  frame.imageIndex = image.imageIndex;
+  frame.encoder.emplace(
+      frame.commandBuffer.begin(vk::info::CommandBufferBegin().oneTime()));
+
+  m_current = &frame;
+  return m_current;
+}
+
+void FrameRing::abandonFrame(FrameContext &frame) {
+  // The frame is not advanced, so the slot is reused next. Consume the
+  // acquire semaphore and signal the fence so `beginFrame` does not hang.
+  frame.fence.reset();
+  vk::info::Submit recovery;
+  recovery.addWaitSemaphore(frame.imageAcquired,
+                            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  if (m_graphics.submit(recovery, &frame.fence).has_value()) {
+    Logger::error("Failed to re-signal frame fence after a failed frame");
+  }
+}
+
+auto FrameRing::endFrame() -> VkResult {
+  if (m_current == nullptr) {
+    Logger::error("endFrame called without a frame in progress");
+    return VK_ERROR_UNKNOWN;
+  }
+
+  auto &frame = *m_current;
+  m_current = nullptr;
+
+  auto ended = frame.encoder->end();
+  frame.encoder.reset();
+  if (ended != VK_SUCCESS) {
+    Logger::error("Failed to end frame command buffer: {}",
+                  static_cast<int>(ended));
+    abandonFrame(frame);
+    return ended;
+  }
+
+  // Any semaphore would do as long as it stays tied to the image
+  auto &renderFinished = m_target->getImageSemaphore(frame.imageIndex);
+
+  vk::info::Submit submitInfo;
+  submitInfo.addCommandBuffer(frame.commandBuffer)
+      .addWaitSemaphore(frame.imageAcquired,
+                        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
+      .addSignalSemaphore(renderFinished);
+
+  frame.fence.reset();
+  auto error = m_graphics.submit(submitInfo, &frame.fence);
+  if (error.has_value()) {
+    Logger::error("Failed to submit frame: {}",
+                  static_cast<int>(VkResult(error.value())));
+
+    abandonFrame(frame);
+    return error.value();
+  }
+
+  m_frameNumber++;
+
+  vk::info::Present presentInfo;
+  uint64_t presentId = frame.frameNumber + 1;
+  auto submitted = std::chrono::steady_clock::now();
+  if (m_presentTiming) {
+    if (m_target->supportsDisplayTiming()) {
+      presentInfo.addPresentTime(static_cast<uint32_t>(presentId));
+    }
+    if (m_target->supportsPresentWait()) {
+      presentInfo.addPresentId(presentId);
+    }
+  }
+
+  auto result = m_target->present(m_present, presentInfo, frame.imageIndex,
+                                  renderFinished);
+
+  // Only presents that were queued will ever be reported
+  if (m_presentTiming &&
+      (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)) {
+    m_pendingPresents.push_back({.id = presentId, .submitted = submitted});
+  }
+  return result;
+}
+} // namespace engine
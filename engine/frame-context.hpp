@@ -0,0 +1,195 @@
+#pragma once
+
+#include "vk/buffers.hpp"
+#include "vk/commands/buffer.hpp"
+#include "vk/commands/pool.hpp"
+#include "vk/deletion-queue.hpp"
+#include "vk/device/memory.hpp"
+#include "vk/present-target.hpp"
+#include "vk/queue.hpp"
+#include "vk/sync/fence.hpp"
+#include "vk/sync/semaphore.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+class Device;
+} // namespace vk
+
+namespace engine {
+// Linear allocator over a persistently mapped host visible buffer, for data
+// written once per frame such as uniforms and dynamic vertices. Everything is
+// released at once by `reset`.
+class TransientBuffer {
+  vk::Buffer m_buffer;
+  vk::DeviceMemory m_memory;
+  vk::Mapping m_mapping;
+  VkDeviceSize m_used = 0;
+
+  TransientBuffer(vk::Buffer &&buffer, vk::DeviceMemory &&memory,
+                  vk::Mapping &&mapping)
+      : m_buffer(std::move(buffer)), m_memory(std::move(memory)),
+        m_mapping(std::move(mapping)) {}
+
+public:
+  struct Allocation {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    void *data;
+  };
+
+  static auto create(vk::Device &device, VkDeviceSize size)
+      -> std::optional<TransientBuffer>;
+
+  TransientBuffer(TransientBuffer &&other) noexcept = default;
+
+  // `alignment` must be a power of two, e.g. the device's
+  // `minUniformBufferOffsetAlignment` for uniforms
+  auto allocate(VkDeviceSize size, VkDeviceSize alignment = 16)
+      -> std::optional<Allocation>;
+
+  void reset() { m_used = 0; }
+
+  [[nodiscard]] auto buffer() -> vk::Buffer & { return m_buffer; }
+  [[nodiscard]] auto used() const -> VkDeviceSize { return m_used; }
+};
+
+// Everything one frame in flight records into. Reused every
+// `framesInFlight` frames, once the GPU is done with it.
+struct FrameContext {
+  vk::CommandPool pool;
+  vk::CommandBuffer commandBuffer;
+  // Signalled when the frame's submission completes
+  vk::Fence fence;
+  vk::Semaphore imageAcquired;
+  TransientBuffer transient;
+
+  uint64_t frameNumber = 0;
+  uint32_t imageIndex = 0;
+  std::optional<vk::CommandBuffer::Encoder> encoder;
+};
+
+// Ring of `framesInFlight` frame contexts paced against a present target, a
+// swapchain or a `vk::HeadlessTarget`. A headless target must have been
+// created with the ring's graphics queue.
+//
+// `beginFrame` only waits for the oldest frame, the one about to be reused,
+// and `endFrame` submits the frame and presents it. The render finished
+// semaphores are the target's per image semaphores, since a semaphore
+// waited on by a present can only be reused once that image is acquired
+// again.
+//
+// Objects retired through the ring are destroyed with it, so wait for the
+// device to go idle before destroying the ring.
+class FrameRing {
+public:
+  struct Stats {
+    // CPU time spent waiting on the frame fence in `beginFrame`
+    double lastWaitMs = 0.0;
+    // Exponential moving average of `lastWaitMs`
+    double averageWaitMs = 0.0;
+    double maxWaitMs = 0.0;
+    uint64_t frames = 0;
+
+    // CPU time spent in the present throttle in `beginFrame`
+    double lastThrottleMs = 0.0;
+    // Time from submitting a frame to it reaching the display, when present
+    // timing is enabled and supported
+    double lastPresentLatencyMs = 0.0;
+    double averagePresentLatencyMs = 0.0;
+    uint64_t presentsMeasured = 0;
+  };
+
+private:
+  struct PendingPresent {
+    uint64_t id;
+    std::chrono::steady_clock::time_point submitted;
+  };
+
+  vk::Queue m_graphics;
+  vk::PresentQueue m_present;
+  vk::PresentTarget *m_target;
+
+  // Heap allocated so the open encoder keeps pointing at its command buffer
+  std::vector<std::unique_ptr<FrameContext>> m_frames;
+  FrameContext *m_current = nullptr;
+  uint64_t m_frameNumber = 0;
+
+  vk::DeletionQueue m_deletions;
+  Stats m_stats;
+
+  bool m_presentTiming = false;
+  bool m_throttle = false;
+  // Presents are tagged with their frame number + 1, ids before this one
+  // went to an earlier target
+  uint64_t m_firstPresentId = 1;
+  std::deque<PendingPresent> m_pendingPresents;
+
+  void collectPresentTimings();
+  // Consume the acquire semaphore of a frame that will not be submitted and
+  // signal its fence, so the slot can be reused
+  void abandonFrame(FrameContext &frame);
+  void recordPresentLatency(std::chrono::nanoseconds latency);
+
+  FrameRing(vk::Queue graphics, vk::PresentQueue present,
+            vk::PresentTarget &target,
+            std::vector<std::unique_ptr<FrameContext>> &&frames)
+      : m_graphics(graphics), m_present(std::move(present)), m_target(&target),
+        m_frames(std::move(frames)) {}
+
+public:
+  static auto create(vk::Device &device, vk::QueueFamily &graphicsFamily,
+                     vk::Queue graphics, vk::PresentQueue present,
+                     vk::PresentTarget &target, uint32_t framesInFlight,
+                     VkDeviceSize transientSize)
+      -> std::optional<FrameRing>;
+
+  FrameRing(FrameRing &&other) noexcept = default;
+
+  [[nodiscard]] auto framesInFlight() const -> uint32_t {
+    return static_cast<uint32_t>(m_frames.size());
+  }
+
+  [[nodiscard]] auto frameNumber() const -> uint64_t { return m_frameNumber; }
+  [[nodiscard]] auto stats() const -> const Stats & { return m_stats; }
+
+  // Destroy `object` once every frame that may still use it has completed,
+  // i.e. once the current frame's slot comes around again
+  template <typename T> void retire(T &&object) {
+    m_deletions.retire(std::forward<T>(object), m_frameNumber);
+  }
+
+  // Point the ring at a recreated swapchain or another target
+  void setTarget(vk::PresentTarget &target);
+
+  // Tag presents with ids and measure submit to display latency, through
+  // VK_GOOGLE_display_timing if the target supports it and otherwise by
+  // polling VK_KHR_present_wait once per frame. With `throttle`,
+  // `beginFrame` also waits until the frame before the previous one has
+  // been displayed, keeping at most one frame queued for presentation.
+  void enablePresentTiming(bool throttle = false) {
+    m_presentTiming = true;
+    m_throttle = throttle;
+  }
+
+  // Wait for the oldest frame, reset its resources, acquire an image and
+  // begin recording. Returns nullptr when the swapchain is out of date and
+  // has to be recreated, or on error.
+  auto beginFrame() -> FrameContext *;
+
+  // Submit the current frame, waiting for the image at
+  // COLOR_ATTACHMENT_OUTPUT, and present it. Returns the present result;
+  // VK_ERROR_OUT_OF_DATE_KHR and VK_SUBOPTIMAL_KHR ask for a new swapchain.
+  // If the frame cannot be ended or submitted it is dropped and the error
+  // returned instead.
+  auto endFrame() -> VkResult;
+};
+} // namespace engine
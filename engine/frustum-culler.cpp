@@ -0,0 +1,266 @@
+#include "frustum-culler.hpp"
+
+#include "logger.hpp"
+
+#include "vk/device/device.hpp"
+#include "vk/enums/shader-stage.hpp"
+#include "vk/shaders/shader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+auto Frustum::fromMatrix(const glm::mat4 &m) -> Frustum {
+  // glm is column major, so row i of the matrix is (m[0][i], ..., m[3][i])
+  auto row = [&m](int i) {
+    return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+  };
+
+  auto r0 = row(0);
+  auto r1 = row(1);
+  auto r2 = row(2);
+  auto r3 = row(3);
+
+  Frustum frustum{.planes = {
+                      r3 + r0, // left
+                      r3 - r0, // right
+                      r3 + r1, // bottom
+                      r3 - r1, // top
+                      r2,      // near, z >= 0
+                      r3 - r2, // far
+                  }};
+
+  for (auto &plane : frustum.planes) {
+    float length = glm::length(glm::vec3(plane));
+    if (length > 0.0f) {
+      plane /= length;
+    }
+  }
+
+  return frustum;
+}
+
+auto isVisible(const Frustum &frustum, const CullInstance &instance) -> bool {
+  glm::vec3 center(instance.sphere);
+  glm::vec3 extent(instance.extent);
+  bool testBox = instance.extent.w != 0.0f;
+
+  for (const auto &plane : frustum.planes) {
+    glm::vec3 normal(plane);
+    float distance = glm::dot(normal, center) + plane.w;
+
+    if (distance < -instance.sphere.w) {
+      return false;
+    }
+
+    if (testBox && distance + glm::dot(glm::abs(normal), extent) < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+auto cullInstances(const CullParams &params,
+                   std::span<const CullInstance> instances)
+    -> std::vector<VkDrawIndexedIndirectCommand> {
+  std::vector<VkDrawIndexedIndirectCommand> draws;
+
+  auto count = std::min<size_t>(params.instanceCount, instances.size());
+  for (size_t i = 0; i < count; i++) {
+    const auto &instance = instances[i];
+    if (!isVisible(params.frustum, instance)) {
+      continue;
+    }
+
+    if (draws.size() >= params.maxDraws) {
+      break;
+    }
+
+    draws.push_back({.indexCount = instance.indexCount,
+                     .instanceCount = 1,
+                     .firstIndex = instance.firstIndex,
+                     .vertexOffset = instance.vertexOffset,
+                     .firstInstance = instance.firstInstance});
+  }
+
+  return draws;
+}
+
+namespace {
+auto drawKey(const VkDrawIndexedIndirectCommand &draw) {
+  return std::tie(draw.firstInstance, draw.firstIndex, draw.indexCount,
+                  draw.vertexOffset, draw.instanceCount);
+}
+
+auto drawLess(const VkDrawIndexedIndirectCommand &a,
+              const VkDrawIndexedIndirectCommand &b) -> bool {
+  return drawKey(a) < drawKey(b);
+}
+} // namespace
+
+auto verifyCulling(const CullParams &params,
+                   std::span<const CullInstance> instances,
+                   std::span<const VkDrawIndexedIndirectCommand> draws,
+                   uint32_t drawCount) -> bool {
+  // The reference stops at maxDraws, so count every visible instance here
+  auto unbounded = params;
+  unbounded.maxDraws = params.instanceCount;
+  auto expected = cullInstances(unbounded, instances);
+
+  if (drawCount != expected.size()) {
+    Logger::error("Frustum culling counted {} visible instances, expected {}",
+                  drawCount, expected.size());
+    return false;
+  }
+
+  auto written = std::min(drawCount, params.maxDraws);
+  if (draws.size() < written) {
+    Logger::error("Frustum culling readback holds {} draws, {} were written",
+                  draws.size(), written);
+    return false;
+  }
+
+  std::vector<VkDrawIndexedIndirectCommand> actual(draws.begin(),
+                                                   draws.begin() + written);
+  std::sort(expected.begin(), expected.end(), drawLess);
+  std::sort(actual.begin(), actual.end(), drawLess);
+
+  // Past maxDraws the GPU keeps an unspecified subset of the visible
+  // instances, so only require each written draw to be one of them
+  bool subset = written < expected.size();
+  bool matches = subset ? std::includes(expected.begin(), expected.end(),
+                                        actual.begin(), actual.end(), drawLess)
+                        : std::equal(expected.begin(), expected.end(),
+                                     actual.begin(), actual.end(),
+                                     [](const auto &a, const auto &b) {
+                                       return drawKey(a) == drawKey(b);
+                                     });
+  if (!matches) {
+    Logger::error("Frustum culling draws differ from the CPU reference");
+    return false;
+  }
+
+  return true;
+}
+
+auto FrustumCuller::create(vk::Device &device, vk::Shader &shader)
+    -> std::optional<FrustumCuller> {
+  auto setLayoutInfo = vk::info::DescriptorSetLayoutCreate();
+  for (uint32_t binding = 0; binding < 4; binding++) {
+    setLayoutInfo.addBinding(vk::DescriptorSetLayoutBinding(
+        binding, vk::DescriptorType::StorageBuffer,
+        vk::ShaderStageFlags::Compute));
+  }
+
+  auto setLayout_opt = device.createDescriptorSetLayout(setLayoutInfo);
+  if (!setLayout_opt.has_value()) {
+    Logger::error("Failed to create frustum culling descriptor set layout");
+    return std::nullopt;
+  }
+  auto &setLayout = setLayout_opt.value();
+
+  auto layoutInfo = vk::info::PipelineLayoutCreate();
+  layoutInfo.addSetLayout(setLayout);
+
+  auto layout_opt = device.createPipelineLayout(layoutInfo);
+  if (!layout_opt.has_value()) {
+    Logger::error("Failed to create frustum culling pipeline layout");
+    return std::nullopt;
+  }
+  auto &layout = layout_opt.value();
+
+  auto pipelineInfo = vk::info::ComputePipelineCreate(
+      layout, vk::info::PipelineShaderStageCreate(shader));
+  auto pipeline_opt = device.createComputePipeline(pipelineInfo);
+  if (!pipeline_opt.has_value()) {
+    Logger::error("Failed to create frustum culling pipeline");
+    return std::nullopt;
+  }
+
+  auto poolInfo = vk::info::DescriptorPoolCreate(1);
+  poolInfo.addPoolSize(
+      vk::DescriptorPoolSize(vk::DescriptorType::StorageBuffer, 4));
+
+  auto pool_opt = device.createDescriptorPool(poolInfo);
+  if (!pool_opt.has_value()) {
+    Logger::error("Failed to create frustum culling descriptor pool");
+    return std::nullopt;
+  }
+  auto &pool = pool_opt.value();
+
+  auto sets_opt = pool.allocateSets(setLayout);
+  if (!sets_opt.has_value()) {
+    Logger::error("Failed to allocate frustum culling descriptor set");
+    return std::nullopt;
+  }
+  auto set = sets_opt->front();
+
+  return FrustumCuller(std::move(setLayout), std::move(layout),
+                       std::move(pipeline_opt.value()), std::move(pool), set);
+}
+
+auto FrustumCuller::bind(vk::Buffer &params, vk::Buffer &instances,
+                         vk::IndirectBuffer &draws, vk::Buffer &drawCount)
+    -> bool {
+  if (!params.isStorage() || !instances.isStorage() || !draws.isStorage() ||
+      !drawCount.isStorage()) {
+    Logger::error("Frustum culling buffers must have storage usage");
+    return false;
+  }
+
+  if (draws.commandType() != vk::IndirectCommandType::DrawIndexed) {
+    Logger::error("Frustum culling writes DrawIndexed commands, got a {} "
+                  "indirect buffer",
+                  draws.commandType().name());
+    return false;
+  }
+
+  if (!drawCount.isIndirect() || !drawCount.canCopyTo()) {
+    Logger::error("Frustum culling draw count buffer must be a bound "
+                  "indirect, transfer destination buffer");
+    return false;
+  }
+
+  std::array<vk::Buffer *, 4> buffers = {&params, &instances, &draws,
+                                         &drawCount};
+  for (uint32_t binding = 0; binding < buffers.size(); binding++) {
+    auto bufferInfo = vk::info::DescriptorBuffer(
+        *buffers[binding], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    auto write = vk::DescriptorSetWriteBuffer(m_set, binding);
+    write.addBuffer(bufferInfo);
+    m_set.update(write);
+  }
+
+  return true;
+}
+
+void FrustumCuller::record(vk::CommandBuffer::Encoder &encoder,
+                           vk::Buffer &drawCount, uint32_t instanceCount) {
+  encoder.fillBuffer(drawCount, 0, 0, sizeof(uint32_t));
+
+  encoder.barriers().memory(
+      {.stages = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+       .access = VK_ACCESS_2_TRANSFER_WRITE_BIT},
+      {.stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+       .access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                 VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT});
+
+  encoder.bindPipeline(m_pipeline);
+  encoder.bindDescriptorSet(m_set);
+  encoder.dispatch((instanceCount + WorkgroupSize - 1) / WorkgroupSize);
+
+  // Left pending so it merges with whatever the caller records next
+  encoder.barriers().memory(
+      {.stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+       .access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT},
+      {.stages = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+       .access = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT});
+}
+} // namespace engine
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "vk/buffers.hpp"
+#include "vk/commands/buffer.hpp"
+#include "vk/descriptors.hpp"
+#include "vk/pipeline/compute.hpp"
+#include "vk/pipeline/layout.hpp"
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+class Device;
+class Shader;
+} // namespace vk
+
+namespace engine {
+// The structs below mirror the std430 blocks in shaders/frustum-cull.comp and
+// must be kept in sync with it.
+
+// Planes are stored as (normal, distance) with normals pointing inwards, so a
+// point p is inside a plane when dot(normal, p) + distance >= 0.
+struct Frustum {
+  std::array<glm::vec4, 6> planes;
+
+  // Extract the planes of a view projection matrix using Vulkan's [0, 1]
+  // clip space depth range.
+  static auto fromMatrix(const glm::mat4 &viewProjection) -> Frustum;
+};
+
+struct CullParams {
+  Frustum frustum;
+  uint32_t instanceCount;
+  // Commands past this are counted but not written
+  uint32_t maxDraws;
+  uint32_t pad[2];
+};
+static_assert(sizeof(CullParams) == 112);
+
+struct CullInstance {
+  // xyz center, w bounding sphere radius
+  glm::vec4 sphere;
+  // xyz AABB half extents around the same center. The box is only tested when
+  // w is non zero, otherwise only the sphere is.
+  glm::vec4 extent;
+
+  // Written to the output command for visible instances, with an instance
+  // count of 1
+  uint32_t indexCount;
+  uint32_t firstIndex;
+  int32_t vertexOffset;
+  uint32_t firstInstance;
+};
+static_assert(sizeof(CullInstance) == 48);
+
+[[nodiscard]] auto isVisible(const Frustum &frustum,
+                             const CullInstance &instance) -> bool;
+
+// CPU reference for the compute pass. Returns the commands for the visible
+// instances in instance order; the GPU pass writes the same set of commands
+// but in an unspecified order. When more than `maxDraws` instances are visible
+// the GPU keeps an unspecified subset of them, so only compare below that.
+auto cullInstances(const CullParams &params,
+                   std::span<const CullInstance> instances)
+    -> std::vector<VkDrawIndexedIndirectCommand>;
+
+// Check the GPU pass against `cullInstances`. `draws` and `drawCount` are the
+// buffer contents read back once the pass completed; the count is the raw
+// value the shader wrote, which may exceed `maxDraws`. Logs the first
+// mismatch and returns false if the visible sets differ.
+auto verifyCulling(const CullParams &params,
+                   std::span<const CullInstance> instances,
+                   std::span<const VkDrawIndexedIndirectCommand> draws,
+                   uint32_t drawCount) -> bool;
+
+// Culls instances against a frustum on the GPU, compacting the visible ones
+// into an indexed indirect buffer and counting them in a separate buffer for
+// use with `drawIndexedIndirectCount`.
+//
+// Descriptor set 0 layout:
+//   0: CullParams (storage)
+//   1: CullInstance[] (storage)
+//   2: VkDrawIndexedIndirectCommand[] (storage, indirect)
+//   3: uint32_t draw count (storage, indirect, transfer dst)
+class FrustumCuller {
+  vk::DescriptorSetLayout m_setLayout;
+  vk::PipelineLayout m_layout;
+  vk::ComputePipeline m_pipeline;
+  vk::DescriptorPool m_pool;
+  vk::DescriptorSet m_set;
+
+  FrustumCuller(vk::DescriptorSetLayout &&setLayout,
+                vk::PipelineLayout &&layout, vk::ComputePipeline &&pipeline,
+                vk::DescriptorPool &&pool, vk::DescriptorSet set)
+      : m_setLayout(std::move(setLayout)), m_layout(std::move(layout)),
+        m_pipeline(std::move(pipeline)), m_pool(std::move(pool)),
+        m_set(set) {}
+
+public:
+  static constexpr uint32_t WorkgroupSize = 64;
+
+  FrustumCuller(FrustumCuller &&other) noexcept = default;
+
+  // `shader` must be the compiled shaders/frustum-cull.comp
+  static auto create(vk::Device &device, vk::Shader &shader)
+      -> std::optional<FrustumCuller>;
+
+  // Point the pass at its buffers. Returns false if any of them lacks the
+  // usage the pass needs.
+  auto bind(vk::Buffer &params, vk::Buffer &instances,
+            vk::IndirectBuffer &draws, vk::Buffer &drawCount) -> bool;
+
+  // Reset the draw count, cull `instanceCount` instances and queue a barrier
+  // making the results visible to indirect draws. Must be recorded outside of
+  // a render pass.
+  void record(vk::CommandBuffer::Encoder &encoder, vk::Buffer &drawCount,
+              uint32_t instanceCount);
+};
+} // namespace engine
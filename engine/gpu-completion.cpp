@@ -0,0 +1,204 @@
+#include "gpu-completion.hpp"
+
+#include "logger.hpp"
+
+#include "vk/device/device.hpp"
+#include "vk/sync/fence.hpp"
+#include "vk/sync/semaphore.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+namespace {
+// Upper bound on how long the waiter sleeps in the driver, so fences are
+// polled and new registrations are picked up promptly
+constexpr uint64_t WaitSlice =
+    std::chrono::nanoseconds(std::chrono::milliseconds(1)).count();
+
+auto promiseCallback(std::shared_ptr<std::promise<void>> promise)
+    -> std::function<void(bool)> {
+  return [promise = std::move(promise)](bool ok) {
+    if (ok) {
+      promise->set_value();
+    } else {
+      promise->set_exception(std::make_exception_ptr(
+          std::runtime_error("Failed to wait for GPU completion")));
+    }
+  };
+}
+} // namespace
+
+GpuCompletion::GpuCompletion(vk::Device &device)
+    : m_device(device.ref()),
+      m_thread([this](const std::stop_token &stop) { run(stop); }) {}
+
+GpuCompletion::~GpuCompletion() {
+  m_thread.request_stop();
+  m_wake.notify_all();
+  m_thread.join();
+
+  for (auto &pending : m_pending) {
+    pending.done(false);
+  }
+}
+
+void GpuCompletion::add(Pending &&pending) {
+  {
+    std::scoped_lock lock(m_mutex);
+    m_pending.push_back(std::move(pending));
+  }
+  m_wake.notify_one();
+}
+
+void GpuCompletion::run(const std::stop_token &stop) {
+  std::vector<Pending> pending;
+  std::vector<VkSemaphore> semaphores;
+  std::vector<uint64_t> values;
+  std::vector<VkFence> fences;
+
+  while (!stop.stop_requested()) {
+    {
+      std::unique_lock lock(m_mutex);
+      m_wake.wait(lock, [&] {
+        return stop.stop_requested() || !m_pending.empty() || !pending.empty();
+      });
+      std::ranges::move(m_pending, std::back_inserter(pending));
+      m_pending.clear();
+    }
+
+    if (stop.stop_requested()) {
+      break;
+    }
+
+    // Sleep in the driver until any timeline value is reached, falling back
+    // to a short sleep when only fences are pending
+    semaphores.clear();
+    values.clear();
+    for (const auto &entry : pending) {
+      if (entry.semaphore != VK_NULL_HANDLE) {
+        semaphores.push_back(entry.semaphore);
+        values.push_back(entry.value);
+      }
+    }
+
+    if (!semaphores.empty()) {
+      VkSemaphoreWaitInfo waitInfo{
+          .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+          .pNext = nullptr,
+          .flags = VK_SEMAPHORE_WAIT_ANY_BIT,
+          .semaphoreCount = static_cast<uint32_t>(semaphores.size()),
+          .pSemaphores = semaphores.data(),
+          .pValues = values.data()};
+      vkWaitSemaphores(m_device, &waitInfo, WaitSlice);
+    } else {
+      fences.clear();
+      for (const auto &entry : pending) {
+        fences.push_back(entry.fence);
+      }
+      vkWaitForFences(m_device, static_cast<uint32_t>(fences.size()),
+                      fences.data(), VK_FALSE, WaitSlice);
+    }
+
+    std::erase_if(pending, [this](Pending &entry) {
+      VkResult result;
+      if (entry.semaphore != VK_NULL_HANDLE) {
+        uint64_t value = 0;
+        result = vkGetSemaphoreCounterValue(m_device, entry.semaphore, &value);
+        if (result == VK_SUCCESS && value < entry.value) {
+          return false;
+        }
+      } else {
+        result = vkGetFenceStatus(m_device, entry.fence);
+        if (result == VK_NOT_READY) {
+          return false;
+        }
+      }
+
+      if (result != VK_SUCCESS) {
+        Logger::error("Failed to query GPU completion: {}",
+                      static_cast<int>(result));
+      }
+      entry.done(result == VK_SUCCESS);
+      return true;
+    });
+  }
+
+  std::scoped_lock lock(m_mutex);
+  std::ranges::move(pending, std::back_inserter(m_pending));
+}
+
+void GpuCompletion::onComplete(const vk::Fence &fence,
+                               std::function<void(bool)> done) {
+  add({.fence = *fence,
+       .semaphore = VK_NULL_HANDLE,
+       .value = 0,
+       .done = std::move(done)});
+}
+
+void GpuCompletion::onComplete(const vk::Semaphore &timeline, uint64_t value,
+                               std::function<void(bool)> done) {
+  if (!timeline.isTimeline()) {
+    Logger::error("Only timeline semaphores can be waited on");
+    done(false);
+    return;
+  }
+
+  add({.fence = VK_NULL_HANDLE,
+       .semaphore = *timeline,
+       .value = value,
+       .done = std::move(done)});
+}
+
+auto GpuCompletion::whenComplete(const vk::Fence &fence) -> std::future<void> {
+  auto promise = std::make_shared<std::promise<void>>();
+  auto future = promise->get_future();
+  onComplete(fence, promiseCallback(std::move(promise)));
+  return future;
+}
+
+auto GpuCompletion::whenComplete(const vk::Semaphore &timeline, uint64_t value)
+    -> std::future<void> {
+  auto promise = std::make_shared<std::promise<void>>();
+  auto future = promise->get_future();
+  onComplete(timeline, value, promiseCallback(std::move(promise)));
+  return future;
+}
+
+auto GpuCompletion::complete(const vk::Fence &fence) -> Awaitable {
+  return {*this, *fence, VK_NULL_HANDLE, 0};
+}
+
+auto GpuCompletion::complete(const vk::Semaphore &timeline, uint64_t value)
+    -> Awaitable {
+  return {*this, VK_NULL_HANDLE, *timeline, value};
+}
+
+auto GpuCompletion::Awaitable::await_ready() const -> bool {
+  // Skip the round trip through the waiter thread for finished work
+  if (m_semaphore != VK_NULL_HANDLE) {
+    uint64_t value = 0;
+    return vkGetSemaphoreCounterValue(m_service.m_device, m_semaphore,
+                                      &value) == VK_SUCCESS &&
+           value >= m_value;
+  }
+  return vkGetFenceStatus(m_service.m_device, m_fence) == VK_SUCCESS;
+}
+
+void GpuCompletion::Awaitable::await_suspend(std::coroutine_handle<> handle) {
+  m_service.add({.fence = m_fence,
+                 .semaphore = m_semaphore,
+                 .value = m_value,
+                 .done = [this, handle](bool ok) {
+                   m_result = ok;
+                   handle.resume();
+                 }});
+}
+} // namespace engine
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "vk/ref.hpp"
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+class Device;
+class Fence;
+class Semaphore;
+} // namespace vk
+
+namespace engine {
+// Resolves callbacks, futures and coroutines when GPU work finishes, without
+// blocking the threads that wait for it.
+//
+// A single background thread waits on every registered fence and timeline
+// value at once. Callbacks and coroutine resumptions run on that thread, so
+// they should hand heavy work back to a worker. Completion is reported as
+// false if waiting fails, e.g. on device loss, or the service shuts down
+// first.
+//
+// The fences and semaphores must outlive their pending waits.
+class GpuCompletion {
+  struct Pending {
+    VkFence fence;
+    VkSemaphore semaphore;
+    uint64_t value;
+    std::function<void(bool)> done;
+  };
+
+  RawRef<vk::Device, VkDevice> m_device;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::vector<Pending> m_pending;
+
+  std::jthread m_thread;
+
+  void add(Pending &&pending);
+  void run(const std::stop_token &stop);
+
+public:
+  explicit GpuCompletion(vk::Device &device);
+  ~GpuCompletion();
+
+  GpuCompletion(const GpuCompletion &) = delete;
+  auto operator=(const GpuCompletion &) -> GpuCompletion & = delete;
+
+  void onComplete(const vk::Fence &fence, std::function<void(bool)> done);
+  void onComplete(const vk::Semaphore &timeline, uint64_t value,
+                  std::function<void(bool)> done);
+
+  // The future throws if waiting failed
+  auto whenComplete(const vk::Fence &fence) -> std::future<void>;
+  auto whenComplete(const vk::Semaphore &timeline, uint64_t value)
+      -> std::future<void>;
+
+  // `co_await completion.complete(timeline, value)` suspends until the value
+  // is reached and resumes on the waiter thread. Evaluates to false if
+  // waiting failed.
+  class Awaitable {
+    GpuCompletion &m_service;
+    VkFence m_fence;
+    VkSemaphore m_semaphore;
+    uint64_t m_value;
+    bool m_result = true;
+
+  public:
+    Awaitable(GpuCompletion &service, VkFence fence, VkSemaphore semaphore,
+              uint64_t value)
+        : m_service(service), m_fence(fence), m_semaphore(semaphore),
+          m_value(value) {}
+
+    [[nodiscard]] auto await_ready() const -> bool;
+    void await_suspend(std::coroutine_handle<> handle);
+    [[nodiscard]] auto await_resume() const -> bool { return m_result; }
+  };
+
+  auto complete(const vk::Fence &fence) -> Awaitable;
+  auto complete(const vk::Semaphore &timeline, uint64_t value) -> Awaitable;
+};
+
+// Fire and forget coroutine for straight line GPU code, e.g.
+//
+//   auto stream(GpuCompletion &gpu, ...) -> GpuTask {
+//     auto value = uploads.upload(...);
+//     uploads.flush();
+//     co_await gpu.complete(timeline.semaphore(), *value);
+//     ...
+//   }
+//
+// It starts immediately and frees itself when it finishes.
+struct GpuTask {
+  struct promise_type {
+    auto get_return_object() -> GpuTask { return {}; }
+    auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+    auto final_suspend() noexcept -> std::suspend_never { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+} // namespace engine
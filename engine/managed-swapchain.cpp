@@ -0,0 +1,146 @@
+#include "managed-swapchain.hpp"
+
+#include "logger.hpp"
+
+#include "vk/device/device.hpp"
+#include "vk/pipeline/renderPass.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+auto ManagedSwapchain::chooseExtent(
+    const VkSurfaceCapabilitiesKHR &capabilities, vk::Extent2D fallback)
+    -> vk::Extent2D {
+  vk::Extent2D extent = capabilities.currentExtent;
+  if (extent.width == UINT32_MAX) {
+    extent.width =
+        std::clamp(fallback.width, capabilities.minImageExtent.width,
+                   capabilities.maxImageExtent.width);
+    extent.height =
+        std::clamp(fallback.height, capabilities.minImageExtent.height,
+                   capabilities.maxImageExtent.height);
+  }
+  return extent;
+}
+
+auto ManagedSwapchain::build(vk::Device &device,
+                             vk::khr::SurfaceAttributes &attributes,
+                             vk::khr::Surface &surface,
+                             const SwapchainConfig &config,
+                             vk::Extent2D extent,
+                             vk::khr::Swapchain *oldSwapchain)
+    -> std::optional<vk::khr::Swapchain> {
+  vk::info::SwapchainCreate info(attributes, surface,
+                                 config.queueFamilies.size() > 1);
+  info.setImageExtent(extent).setPresentPolicy(
+      config.policy, config.allowTearing, config.imageCount);
+
+  if (!config.formats.empty()) {
+    info.setPreferredFormats(config.formats);
+  }
+
+  if (config.queueFamilies.size() > 1) {
+    auto families = config.queueFamilies;
+    info.setQueueFamilyIndices(families);
+  }
+
+  if (oldSwapchain != nullptr) {
+    info.setOldSwapchain(*oldSwapchain);
+  }
+
+  return device.createSwapchain(info);
+}
+
+auto ManagedSwapchain::create(vk::Device &device,
+                              vk::PhysicalDevice physicalDevice,
+                              vk::khr::Surface &surface, SwapchainConfig config,
+                              vk::Extent2D extent)
+    -> std::optional<ManagedSwapchain> {
+  vk::khr::SurfaceAttributes attributes(physicalDevice, surface);
+  auto imageExtent = chooseExtent(attributes.capabilities, extent);
+  if (imageExtent.width == 0 || imageExtent.height == 0) {
+    Logger::error("Cannot create a swapchain for a surface without area");
+    return std::nullopt;
+  }
+
+  auto swapchain =
+      build(device, attributes, surface, config, imageExtent, nullptr);
+  if (!swapchain.has_value()) {
+    Logger::error("Failed to create swapchain");
+    return std::nullopt;
+  }
+
+  return ManagedSwapchain(
+      device, std::move(physicalDevice), surface, std::move(config),
+      std::make_unique<vk::khr::Swapchain>(std::move(swapchain.value())));
+}
+
+auto ManagedSwapchain::recreate(FrameRing &ring, vk::Extent2D extent) -> bool {
+  // Queried every time, the current extent follows the window
+  vk::khr::SurfaceAttributes attributes(m_physicalDevice, *m_surface);
+  auto imageExtent = chooseExtent(attributes.capabilities, extent);
+  if (imageExtent.width == 0 || imageExtent.height == 0) {
+    return false;
+  }
+
+  auto *oldSwapchain = isValid() ? m_swapchain.get() : nullptr;
+  auto swapchain = build(*m_device, attributes, *m_surface, m_config,
+                         imageExtent, oldSwapchain);
+
+  // Frames still in flight may present from the old swapchain, so it lives
+  // until the ring has cycled past them. It is retired on failure too, as
+  // passing it as oldSwapchain already did so.
+  if (oldSwapchain != nullptr) {
+    ring.retire(std::move(*m_swapchain));
+  }
+  for (auto &framebuffer : m_framebuffers) {
+    ring.retire(std::move(framebuffer));
+  }
+  m_framebuffers.clear();
+
+  if (!swapchain.has_value()) {
+    Logger::error("Failed to recreate swapchain, a full rebuild is needed");
+    return false;
+  }
+
+  m_swapchain =
+      std::make_unique<vk::khr::Swapchain>(std::move(swapchain.value()));
+  ring.setTarget(*m_swapchain);
+  m_generation++;
+
+  Logger::info("Swapchain recreated at {}x{}", m_swapchain->getExtent().width,
+               m_swapchain->getExtent().height);
+  return true;
+}
+
+auto ManagedSwapchain::framebuffers(FrameRing &ring,
+                                    vk::RenderPass &renderPass)
+    -> std::vector<vk::Framebuffer> * {
+  if (!isValid()) {
+    return nullptr;
+  }
+
+  if (!m_framebuffers.empty() && m_framebufferGeneration == m_generation &&
+      m_framebufferPass == *renderPass) {
+    return &m_framebuffers;
+  }
+
+  auto framebuffers = m_swapchain->createFramebuffers(renderPass);
+  if (!framebuffers.has_value()) {
+    return nullptr;
+  }
+
+  for (auto &framebuffer : m_framebuffers) {
+    ring.retire(std::move(framebuffer));
+  }
+
+  m_framebuffers = std::move(framebuffers.value());
+  m_framebufferPass = *renderPass;
+  m_framebufferGeneration = m_generation;
+  return &m_framebuffers;
+}
+} // namespace engine
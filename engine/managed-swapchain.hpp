@@ -0,0 +1,107 @@
+#pragma once
+
+#include "frame-context.hpp"
+
+#include "vk/device/physical.hpp"
+#include "vk/framebuffer.hpp"
+#include "vk/khr/surface.hpp"
+#include "vk/khr/swapchain.hpp"
+#include "vk/ref.hpp"
+#include "vk/structs/extent2d.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+class Device;
+class RenderPass;
+} // namespace vk
+
+namespace engine {
+struct SwapchainConfig {
+  vk::PresentPolicy policy = vk::PresentPolicy::Throughput;
+  bool allowTearing = false;
+  std::optional<uint32_t> imageCount;
+  // Tried in order, the surface's first format is used if none match
+  std::vector<VkSurfaceFormatKHR> formats;
+  // More than one family shares the images concurrently
+  std::vector<uint32_t> queueFamilies;
+};
+
+// Owns the swapchain of a `FrameRing` and recreates it on resize without
+// waiting for the device to go idle.
+//
+// The new swapchain is created with the current one as `oldSwapchain`, and
+// the old swapchain and its framebuffers are retired through the ring, so
+// they are destroyed once the frames that used them have completed.
+// Framebuffers are only rebuilt when they are next asked for.
+class ManagedSwapchain {
+  RawRef<vk::Device, VkDevice> m_device;
+  vk::PhysicalDevice m_physicalDevice;
+  vk::khr::Surface *m_surface;
+  SwapchainConfig m_config;
+
+  // Heap allocated so the ring's pointer survives moving the manager
+  std::unique_ptr<vk::khr::Swapchain> m_swapchain;
+  uint64_t m_generation = 0;
+
+  std::vector<vk::Framebuffer> m_framebuffers;
+  VkRenderPass m_framebufferPass = VK_NULL_HANDLE;
+  uint64_t m_framebufferGeneration = 0;
+
+  ManagedSwapchain(vk::Device &device, vk::PhysicalDevice physicalDevice,
+                   vk::khr::Surface &surface, SwapchainConfig &&config,
+                   std::unique_ptr<vk::khr::Swapchain> &&swapchain)
+      : m_device(device.ref()), m_physicalDevice(std::move(physicalDevice)),
+        m_surface(&surface), m_config(std::move(config)),
+        m_swapchain(std::move(swapchain)) {}
+
+  // The surface's current extent, or `fallback` clamped to its limits when
+  // the surface leaves the size to the swapchain
+  static auto chooseExtent(const VkSurfaceCapabilitiesKHR &capabilities,
+                           vk::Extent2D fallback) -> vk::Extent2D;
+
+  static auto build(vk::Device &device, vk::khr::SurfaceAttributes &attributes,
+                    vk::khr::Surface &surface, const SwapchainConfig &config,
+                    vk::Extent2D extent, vk::khr::Swapchain *oldSwapchain)
+      -> std::optional<vk::khr::Swapchain>;
+
+public:
+  // `extent` is only used when the surface leaves the size to the swapchain,
+  // pass the window's framebuffer size
+  static auto create(vk::Device &device, vk::PhysicalDevice physicalDevice,
+                     vk::khr::Surface &surface, SwapchainConfig config,
+                     vk::Extent2D extent) -> std::optional<ManagedSwapchain>;
+
+  ManagedSwapchain(ManagedSwapchain &&other) noexcept = default;
+
+  auto get() -> vk::khr::Swapchain & { return *m_swapchain; }
+  auto operator*() -> vk::khr::Swapchain & { return *m_swapchain; }
+  auto operator->() -> vk::khr::Swapchain * { return m_swapchain.get(); }
+
+  // Incremented by every successful `recreate`
+  [[nodiscard]] auto generation() const -> uint64_t { return m_generation; }
+
+  // False after a failed `recreate`. No frame may begin until a later
+  // `recreate` succeeds.
+  [[nodiscard]] auto isValid() const -> bool { return m_swapchain->isValid(); }
+
+  // Replace the swapchain, retiring the old one through `ring`. Call between
+  // frames, e.g. when `beginFrame` returns nullptr or `endFrame` reports the
+  // swapchain out of date. Returns false when the surface has no area (a
+  // minimized window), keeping the current swapchain, or when creation
+  // fails. Creation retires the old swapchain even when it fails, so it is
+  // retired through `ring` then as well and `isValid` turns false; the next
+  // `recreate` builds from scratch.
+  auto recreate(FrameRing &ring, vk::Extent2D extent) -> bool;
+
+  // Framebuffers for every swapchain image with a single color attachment,
+  // rebuilt on first use after a recreate or with a different render pass.
+  // Nullptr when they could not be created or the swapchain is not valid.
+  auto framebuffers(FrameRing &ring, vk::RenderPass &renderPass)
+      -> std::vector<vk::Framebuffer> *;
+};
+} // namespace engine
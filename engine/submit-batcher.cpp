@@ -0,0 +1,135 @@
+#include "submit-batcher.hpp"
+
+#include "logger.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+auto SubmitBatcher::addQueue(vk::Queue &queue, vk::QueueTimeline &timeline)
+    -> uint32_t {
+  m_queues.push_back({.queue = &queue, .timeline = &timeline});
+  return static_cast<uint32_t>(m_queues.size() - 1);
+}
+
+auto SubmitBatcher::add(uint32_t queue, vk::info::Submit2 submit,
+                        std::span<const SubmissionId> after,
+                        VkPipelineStageFlags2 waitStages) -> SubmissionId {
+  auto id = static_cast<SubmissionId>(m_submissions.size());
+
+  std::vector<SubmissionId> dependencies;
+  dependencies.reserve(after.size());
+  for (auto dependency : after) {
+    if (dependency >= id) {
+      Logger::error("Submission {} cannot depend on unknown submission {}",
+                    id, dependency);
+      continue;
+    }
+    dependencies.push_back(dependency);
+  }
+
+  m_submissions.push_back({.queue = queue,
+                           .info = std::move(submit),
+                           .after = std::move(dependencies),
+                           .waitStages = waitStages});
+  return id;
+}
+
+auto SubmitBatcher::submitPending(uint32_t queue) -> bool {
+  auto &pending = m_pending[queue];
+  if (pending.empty()) {
+    return true;
+  }
+
+  auto &timeline = *m_queues[queue].timeline;
+  m_submissions[pending.back()].signals = true;
+
+  // Values are handed out in submission order so each timeline only grows
+  uint64_t value = timeline.submitted();
+  m_infos.clear();
+  for (auto id : pending) {
+    auto &submission = m_submissions[id];
+    if (submission.signals) {
+      submission.value = ++value;
+      timeline.addSignal(submission.info, submission.value);
+    }
+    m_infos.push_back(submission.info);
+  }
+
+  auto error = m_queues[queue].queue->submit2(m_infos);
+  auto state = error.has_value() ? State::Failed : State::Submitted;
+  for (auto id : pending) {
+    m_submissions[id].state = state;
+  }
+  pending.clear();
+
+  if (error.has_value()) {
+    Logger::error("Failed to submit batch to queue {}: {}", queue,
+                  static_cast<int>(static_cast<VkResult>(error.value())));
+    return false;
+  }
+
+  timeline.commit(value);
+  return true;
+}
+
+auto SubmitBatcher::flush() -> bool {
+  if (m_submissions.empty()) {
+    return true;
+  }
+
+  // Mark every submission another queue waits on
+  for (const auto &submission : m_submissions) {
+    for (auto dependency : submission.after) {
+      auto &source = m_submissions[dependency];
+      if (source.queue != submission.queue) {
+        source.signals = true;
+      }
+    }
+  }
+
+  m_pending.resize(m_queues.size());
+
+  bool ok = true;
+  for (SubmissionId id = 0; id < m_submissions.size(); id++) {
+    auto &submission = m_submissions[id];
+
+    // Submit what this one waits on first, so its values are known to exist
+    bool skip = false;
+    for (auto dependency : submission.after) {
+      const auto &source = m_submissions[dependency];
+      if (source.state == State::Queued && source.queue != submission.queue) {
+        ok = submitPending(source.queue) && ok;
+      }
+      skip = skip || source.state == State::Failed;
+    }
+
+    if (skip) {
+      Logger::error("Skipping submission {}, a dependency failed to submit",
+                    id);
+      submission.state = State::Failed;
+      ok = false;
+      continue;
+    }
+
+    for (auto dependency : submission.after) {
+      const auto &source = m_submissions[dependency];
+      if (source.queue != submission.queue) {
+        m_queues[source.queue].timeline->addWait(
+            submission.info, source.value, submission.waitStages);
+      }
+    }
+
+    m_pending[submission.queue].push_back(id);
+  }
+
+  for (uint32_t queue = 0; queue < m_queues.size(); queue++) {
+    ok = submitPending(queue) && ok;
+  }
+
+  m_submissions.clear();
+  return ok;
+}
+} // namespace engine
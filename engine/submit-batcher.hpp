@@ -0,0 +1,79 @@
+#pragma once
+
+#include "vk/queue.hpp"
+#include "vk/sync/timeline.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+// Collects a frame's submissions from every subsystem and issues them with
+// as few vkQueueSubmit2 calls as possible in `flush`, usually one per queue.
+//
+// Submissions may only depend on ones added before them, so the order they
+// were added in is already a valid order. Within a queue that order is kept,
+// which is enough for pipeline barriers in the command buffers to apply.
+// Across queues the dependency signals the next value of its queue's timeline
+// and the dependent submission waits for it. A queue's batch is submitted
+// before anything on another queue that waits on it, so a wait is only ever
+// submitted for a value that was actually submitted; work depending on a
+// failed submit is dropped instead of waiting forever.
+//
+// The last submission of every batch signals its timeline, so
+// `QueueTimeline::submitted` covers all work flushed on that queue.
+class SubmitBatcher {
+public:
+  using SubmissionId = uint32_t;
+
+private:
+  struct Queue {
+    vk::Queue *queue;
+    vk::QueueTimeline *timeline;
+  };
+
+  enum class State { Queued, Submitted, Failed };
+
+  struct Submission {
+    uint32_t queue;
+    vk::info::Submit2 info;
+    std::vector<SubmissionId> after;
+    VkPipelineStageFlags2 waitStages;
+    bool signals = false;
+    State state = State::Queued;
+    // Timeline value signalled by this submission, 0 if none
+    uint64_t value = 0;
+  };
+
+  std::vector<Queue> m_queues;
+  std::vector<Submission> m_submissions;
+
+  // Reused between flushes to keep the per frame path allocation free
+  std::vector<VkSubmitInfo2> m_infos;
+  std::vector<std::vector<SubmissionId>> m_pending;
+
+  auto submitPending(uint32_t queue) -> bool;
+
+public:
+  // Register a queue and the timeline its submissions signal. The returned
+  // index identifies the queue in `add`.
+  auto addQueue(vk::Queue &queue, vk::QueueTimeline &timeline) -> uint32_t;
+
+  // Queue a submission for the next flush, running after the submissions in
+  // `after`, which must have been added earlier in the same frame. Cross
+  // queue dependencies are waited for at `waitStages`.
+  auto add(uint32_t queue, vk::info::Submit2 submit,
+           std::span<const SubmissionId> after = {},
+           VkPipelineStageFlags2 waitStages =
+               VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) -> SubmissionId;
+
+  [[nodiscard]] auto size() const -> size_t { return m_submissions.size(); }
+
+  // Submit everything queued since the last flush. Returns false if a submit
+  // fails, in which case everything depending on it is skipped as well;
+  // submissions are dropped either way.
+  auto flush() -> bool;
+};
+} // namespace engine
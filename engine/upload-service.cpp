@@ -0,0 +1,258 @@
+#include "upload-service.hpp"
+
+#include "logger.hpp"
+
+#include "vk/device/device.hpp"
+#include "vk/enums/memory-properties.hpp"
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace engine {
+namespace {
+// Keeps each staged copy aligned for any element type
+constexpr VkDeviceSize StagingAlignment = 16;
+
+constexpr auto alignUp(VkDeviceSize value) -> VkDeviceSize {
+  return (value + StagingAlignment - 1) & ~(StagingAlignment - 1);
+}
+} // namespace
+
+auto UploadService::create(vk::Device &device, vk::QueueFamily &transferFamily,
+                           uint32_t dstFamily, VkDeviceSize stagingSize,
+                           uint32_t batchCount, uint32_t queueIndex)
+    -> std::optional<UploadService> {
+  if (!transferFamily.hasTransfer()) {
+    Logger::error("Queue family {} does not support transfers",
+                  transferFamily.getIndex());
+    return std::nullopt;
+  }
+
+  if (batchCount == 0 || stagingSize == 0) {
+    Logger::error("Upload service needs at least one non empty batch");
+    return std::nullopt;
+  }
+
+  auto queue = device.getQueue(transferFamily, queueIndex);
+  if (!queue.has_value()) {
+    Logger::error("Failed to get transfer queue");
+    return std::nullopt;
+  }
+
+  auto poolInfo = vk::info::CommandPoolCreate(transferFamily, true, true);
+  auto pool = device.createCommandPool(poolInfo);
+  if (!pool.has_value()) {
+    Logger::error("Failed to create transfer command pool");
+    return std::nullopt;
+  }
+
+  auto timeline = vk::QueueTimeline::create(device);
+  if (!timeline.has_value()) {
+    return std::nullopt;
+  }
+
+  auto commandBuffers = pool->allocBuffers(batchCount);
+  if (!commandBuffers.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<std::unique_ptr<Batch>> batches;
+  batches.reserve(batchCount);
+  for (auto &commandBuffer : commandBuffers.value()) {
+    auto stagingInfo = vk::info::BufferCreate(vk::Size(stagingSize),
+                                              vk::BufferUsage::TransferSrc);
+    auto staging = device.createBuffer(stagingInfo);
+    if (!staging.has_value()) {
+      Logger::error("Failed to create upload staging buffer");
+      return std::nullopt;
+    }
+
+    auto memory = device.allocateMemory(staging.value(),
+                                        vk::MemoryProperties::HostVisible |
+                                            vk::MemoryProperties::HostCoherent);
+    if (!memory.has_value()) {
+      Logger::error("Failed to allocate upload staging memory");
+      return std::nullopt;
+    }
+
+    if (staging->bind(memory.value()).has_value()) {
+      Logger::error("Failed to bind upload staging memory");
+      return std::nullopt;
+    }
+
+    auto mapping = memory->map();
+    if (!mapping.has_value()) {
+      Logger::error("Failed to map upload staging memory");
+      return std::nullopt;
+    }
+
+    batches.push_back(std::make_unique<Batch>(Batch{
+        .commandBuffer = commandBuffer,
+        .staging = std::move(staging.value()),
+        .memory = std::move(memory.value()),
+        .mapping = std::move(mapping.value()),
+    }));
+  }
+
+  return UploadService(queue.value(), dstFamily, std::move(pool.value()),
+                       std::move(timeline.value()), stagingSize,
+                       std::move(batches));
+}
+
+auto UploadService::openBatch(VkDeviceSize size) -> Batch * {
+  if (m_open != nullptr && alignUp(m_open->used) + size <= m_stagingSize) {
+    return m_open;
+  }
+
+  if (m_open != nullptr && !flush()) {
+    return nullptr;
+  }
+
+  auto completed = completedValue();
+  for (auto &batch : m_batches) {
+    if (batch->value > completed) {
+      continue;
+    }
+
+    batch->used = 0;
+    batch->commandBuffer.reset();
+    batch->encoder.emplace(batch->commandBuffer.begin(
+        vk::info::CommandBufferBegin().oneTime()));
+    m_open = batch.get();
+    return m_open;
+  }
+
+  return nullptr;
+}
+
+auto UploadService::upload(vk::Buffer &dst, std::span<const std::byte> data,
+                           VkDeviceSize offset, vk::BarrierScope dstScope)
+    -> std::optional<uint64_t> {
+  VkDeviceSize size = data.size_bytes();
+  if (size == 0) {
+    return m_timeline.submitted();
+  }
+
+  if (size > m_stagingSize) {
+    Logger::error("Upload of {} bytes exceeds the staging size of {} bytes",
+                  size, m_stagingSize);
+    return std::nullopt;
+  }
+
+  if (offset + size > dst.size()) {
+    Logger::error("Upload of {} bytes at offset {} overflows {} of size {}",
+                  size, offset, dst.bufferTypeName(), dst.size());
+    return std::nullopt;
+  }
+
+  auto *batch = openBatch(size);
+  if (batch == nullptr) {
+    Logger::debug("No staging space left for a {} byte upload", size);
+    return std::nullopt;
+  }
+
+  auto stagingOffset = alignUp(batch->used);
+  batch->mapping.write(const_cast<std::byte *>(data.data()), vk::Size(size),
+                       vk::Offset(stagingOffset));
+  batch->used = stagingOffset + size;
+
+  auto &encoder = batch->encoder.value();
+  encoder.copyBuffer(batch->staging, dst,
+                     VkBufferCopy{.srcOffset = stagingOffset,
+                                  .dstOffset = offset,
+                                  .size = size});
+
+  if (m_queue.getFamilyIndex() != m_dstFamily) {
+    encoder.barriers().buffer(*dst,
+                              {.stages = VK_PIPELINE_STAGE_2_COPY_BIT,
+                               .access = VK_ACCESS_2_TRANSFER_WRITE_BIT},
+                              {}, offset, size, m_queue.getFamilyIndex(),
+                              m_dstFamily);
+  }
+
+  m_acquires.push_back({.buffer = *dst,
+                        .dst = dstScope,
+                        .offset = offset,
+                        .size = size,
+                        .value = m_timeline.next()});
+
+  return m_timeline.next();
+}
+
+auto UploadService::flush() -> bool {
+  if (m_open == nullptr) {
+    return true;
+  }
+
+  auto *batch = m_open;
+  m_open = nullptr;
+
+  auto value = m_timeline.next();
+
+  auto result = batch->encoder->end();
+  batch->encoder.reset();
+  if (result != VK_SUCCESS) {
+    Logger::error("Failed to end upload command buffer: {}",
+                  static_cast<int>(result));
+    dropBatch(value);
+    return false;
+  }
+
+  vk::info::Submit submitInfo;
+  submitInfo.addCommandBuffer(batch->commandBuffer);
+  m_timeline.addSignal(submitInfo, value);
+
+  auto error = m_queue.submit(submitInfo);
+  if (error.has_value()) {
+    Logger::error("Failed to submit uploads: {}",
+                  static_cast<int>(static_cast<VkResult>(error.value())));
+    dropBatch(value);
+    return false;
+  }
+
+  m_timeline.commit(value);
+  batch->value = value;
+  return true;
+}
+
+void UploadService::dropBatch(uint64_t value) {
+  // The copies never ran, so nothing may acquire them, and the value must not
+  // be promised for the next batch's copies
+  std::erase_if(m_acquires, [value](const Acquire &acquire) {
+    return acquire.value == value;
+  });
+  m_timeline.skip(value);
+  m_failed.push_back(value);
+}
+
+void UploadService::acquire(vk::CommandBuffer::Encoder &encoder) {
+  bool transfer = m_queue.getFamilyIndex() != m_dstFamily;
+
+  std::erase_if(m_acquires, [&](const Acquire &acquire) {
+    if (acquire.value > m_timeline.submitted()) {
+      return false;
+    }
+
+    if (transfer) {
+      encoder.barriers().buffer(acquire.buffer, {}, acquire.dst,
+                                acquire.offset, acquire.size,
+                                m_queue.getFamilyIndex(), m_dstFamily);
+    }
+    return true;
+  });
+
+  m_acquiredValue = m_timeline.submitted();
+}
+
+void UploadService::addDependency(vk::info::Submit &submit,
+                                  VkPipelineStageFlags stages) {
+  if (m_acquiredValue == 0) {
+    return;
+  }
+
+  m_timeline.addWait(submit, m_acquiredValue, stages);
+}
+} // namespace engine
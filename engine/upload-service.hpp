@@ -0,0 +1,149 @@
+#pragma once
+
+#include "vk/buffers.hpp"
+#include "vk/commands/buffer.hpp"
+#include "vk/commands/pool.hpp"
+#include "vk/device/memory.hpp"
+#include "vk/queue.hpp"
+#include "vk/sync/barrier.hpp"
+#include "vk/sync/timeline.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+class Device;
+} // namespace vk
+
+namespace engine {
+// Streams buffer uploads through a transfer queue so copies run beside
+// rendering instead of inside the frame's command buffer.
+//
+// Copies are staged into one of a few persistently mapped staging buffers and
+// batched into a single command buffer until `flush`, which submits the batch
+// and signals the next value of a timeline semaphore. Render submissions wait
+// on that value through `acquire` and `addDependency`; `acquire` also records
+// the acquire half of the queue family ownership transfer when the transfer
+// family differs from the destination family.
+//
+// Nothing here blocks the host: when every staging buffer is still in flight
+// `upload` fails and the caller should retry on a later frame.
+//
+// Requires Vulkan 1.2 with `timelineSemaphore` enabled.
+class UploadService {
+  struct Batch {
+    vk::CommandBuffer commandBuffer;
+    vk::Buffer staging;
+    vk::DeviceMemory memory;
+    vk::Mapping mapping;
+    std::optional<vk::CommandBuffer::Encoder> encoder;
+    VkDeviceSize used = 0;
+    // Timeline value signalled once the batch completes, 0 if never submitted
+    uint64_t value = 0;
+  };
+
+  struct Acquire {
+    VkBuffer buffer;
+    vk::BarrierScope dst;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    uint64_t value;
+  };
+
+  vk::Queue m_queue;
+  uint32_t m_dstFamily;
+  vk::CommandPool m_pool;
+  vk::QueueTimeline m_timeline;
+  VkDeviceSize m_stagingSize;
+
+  // Heap allocated so open encoders keep pointing at their command buffers
+  std::vector<std::unique_ptr<Batch>> m_batches;
+  Batch *m_open = nullptr;
+
+  uint64_t m_acquiredValue = 0;
+  std::vector<Acquire> m_acquires;
+  // Values returned by `upload` whose batch never ran
+  std::vector<uint64_t> m_failed;
+
+  UploadService(vk::Queue queue, uint32_t dstFamily, vk::CommandPool &&pool,
+                vk::QueueTimeline &&timeline, VkDeviceSize stagingSize,
+                std::vector<std::unique_ptr<Batch>> &&batches)
+      : m_queue(queue), m_dstFamily(dstFamily), m_pool(std::move(pool)),
+        m_timeline(std::move(timeline)), m_stagingSize(stagingSize),
+        m_batches(std::move(batches)) {}
+
+  auto openBatch(VkDeviceSize size) -> Batch *;
+  void dropBatch(uint64_t value);
+
+public:
+  // `transferFamily` is usually `QueueFamilies::getTransfer()` and
+  // `dstFamily` the family the uploaded buffers are used on. Each of the
+  // `batchCount` staging buffers holds `stagingSize` bytes, which bounds the
+  // size of a single upload.
+  static auto create(vk::Device &device, vk::QueueFamily &transferFamily,
+                     uint32_t dstFamily, VkDeviceSize stagingSize,
+                     uint32_t batchCount = 3, uint32_t queueIndex = 0)
+      -> std::optional<UploadService>;
+
+  UploadService(UploadService &&other) noexcept = default;
+
+  // Queue a copy of `data` into `dst` at `offset`, to be used with the
+  // accesses in `dstScope` after the ownership transfer. Returns the timeline
+  // value at which the copy is complete, or nullopt if there is no staging
+  // space left right now.
+  auto upload(vk::Buffer &dst, std::span<const std::byte> data,
+              VkDeviceSize offset = 0,
+              vk::BarrierScope dstScope = {
+                  .stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                  .access = VK_ACCESS_2_MEMORY_READ_BIT})
+      -> std::optional<uint64_t>;
+
+  template <typename T>
+  auto upload(vk::Buffer &dst, std::span<const T> data,
+              VkDeviceSize offset = 0,
+              vk::BarrierScope dstScope = {
+                  .stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                  .access = VK_ACCESS_2_MEMORY_READ_BIT})
+      -> std::optional<uint64_t> {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return upload(dst, std::as_bytes(data), offset, dstScope);
+  }
+
+  // Submit the open batch, if any. Call once per frame before the render
+  // submission that should see the uploads. On failure the batch's uploads
+  // are dropped and have to be issued again, and `failed` reports the value
+  // `upload` returned for them.
+  auto flush() -> bool;
+
+  // Whether the uploads `upload` returned `value` for were dropped. The
+  // value is never reused but still completes with later batches, so check
+  // this before trusting a wait on it.
+  [[nodiscard]] auto failed(uint64_t value) const -> bool {
+    return std::ranges::find(m_failed, value) != m_failed.end();
+  }
+
+  // Timeline value of the last completed batch
+  [[nodiscard]] auto completedValue() const -> uint64_t {
+    return m_timeline.completed();
+  }
+
+  [[nodiscard]] auto submittedValue() const -> uint64_t {
+    return m_timeline.submitted();
+  }
+
+  // Queue the acquire barriers of every submitted upload on a destination
+  // queue encoder. The command buffer must be submitted with `addDependency`.
+  void acquire(vk::CommandBuffer::Encoder &encoder);
+
+  // Make a render submission wait for the uploads acquired so far. `stages`
+  // should cover the destination stages the uploads were queued with.
+  void addDependency(vk::info::Submit &submit, VkPipelineStageFlags stages);
+};
+} // namespace engine
@@ -23,7 +23,10 @@ auto Buffer::create(Device &device, vk::info::BufferCreate &createInfo)
   return Buffer(buffer, device, Size(createInfo.size), createInfo.usage);
 }
 
-auto Buffer::destroy() -> void { vkDestroyBuffer(m_device, m_handle, nullptr); }
+auto Buffer::destroy() -> void {
+  vkDestroyBuffer(m_device, m_handle, nullptr);
+  expireVersion();
+}
 
 auto Buffer::bind(DeviceMemory &memory, vk::Offset offset, bool align)
     -> std::optional<BindError> {
@@ -108,4 +111,84 @@ auto VertexBuffer::create(Device &device,
 
   return VertexBuffer(buffer, device, Size(createInfo.size), createInfo.usage);
 }
+
+auto IndirectBuffer::create(Device &device,
+                            vk::info::IndirectBufferCreate &createInfo)
+    -> std::optional<IndirectBuffer> {
+  VkBuffer buffer;
+  if (vkCreateBuffer(*device, &createInfo, nullptr, &buffer) != VK_SUCCESS) {
+    return std::nullopt;
+  }
+
+  return IndirectBuffer(buffer, device, Size(createInfo.size),
+                        createInfo.usage, createInfo.commandType());
+}
+
+auto IndirectBuffer::canRead(IndirectCommandType type, uint32_t count,
+                             VkDeviceSize offset) const -> bool {
+  if (type != m_commandType) {
+    Logger::error("Indirect buffer holds {} commands, not {} commands",
+                  m_commandType.name(), type.name());
+    return false;
+  }
+
+  if (offset % 4 != 0) {
+    Logger::error("Indirect buffer offset {} is not a multiple of 4", offset);
+    return false;
+  }
+
+  if (offset + static_cast<VkDeviceSize>(count) * stride() > m_size) {
+    Logger::error("Reading {} indirect commands at offset {} overruns the "
+                  "indirect buffer of size {}",
+                  count, offset, m_size);
+    return false;
+  }
+
+  return true;
+}
+
+auto IndirectBuffer::canDraw(IndirectCommandType type, uint32_t drawCount,
+                             VkDeviceSize offset) const -> bool {
+  if (drawCount > 1 && !m_device->multiDrawIndirectEnabled()) {
+    Logger::error("Indirect draws of {} commands need the multiDrawIndirect "
+                  "feature",
+                  drawCount);
+    return false;
+  }
+
+  return canRead(type, drawCount, offset);
+}
+
+auto IndirectBuffer::canDrawCount(IndirectCommandType type,
+                                  uint32_t maxDrawCount, VkDeviceSize offset,
+                                  const Buffer &countBuffer,
+                                  VkDeviceSize countOffset) const -> bool {
+  if (!m_device->drawIndirectCountEnabled()) {
+    Logger::error("Indirect count draws need the drawIndirectCount feature");
+    return false;
+  }
+
+  if (!canRead(type, maxDrawCount, offset)) {
+    return false;
+  }
+
+  if (!countBuffer.isIndirect()) {
+    Logger::error("Draw count buffer was not created with indirect usage");
+    return false;
+  }
+
+  if (countOffset % 4 != 0) {
+    Logger::error("Draw count offset {} is not a multiple of 4", countOffset);
+    return false;
+  }
+
+  if (countOffset + sizeof(uint32_t) > countBuffer.size()) {
+    Logger::error("Draw count at offset {} overruns the count buffer of size "
+                  "{}",
+                  countOffset, countBuffer.size());
+    return false;
+  }
+
+  return true;
+}
 } // namespace vk
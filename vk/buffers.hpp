@@ -4,9 +4,11 @@
 #include "offset.hpp"
 #include "ref.hpp"
 #include "size.hpp"
+#include "versioned.hpp"
 
 #include "enums/buffer-usage.hpp"
 #include "enums/index-type.hpp"
+#include "enums/indirect-command-type.hpp"
 #include "enums/sharing-mode.hpp"
 
 #include <optional>
@@ -107,9 +109,34 @@ public:
                      sharingMode) {}
 };
 
+class IndirectBufferCreate : public BufferCreate {
+  IndirectCommandType m_commandType;
+
+public:
+  IndirectBufferCreate(
+      IndirectCommandType commandType = IndirectCommandType::Draw)
+      : BufferCreate(), m_commandType(commandType) {
+    usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+  }
+
+  // Sized to hold `commandCount` tightly packed commands of `commandType`
+  IndirectBufferCreate(uint32_t commandCount, IndirectCommandType commandType,
+                       BufferUsage additionalUsage = BufferUsage::None,
+                       SharingMode sharingMode = SharingMode::Exclusive)
+      : BufferCreate(Size(static_cast<VkDeviceSize>(commandCount) *
+                          commandType.stride()),
+                     BufferUsage::IndirectBuffer | additionalUsage,
+                     sharingMode),
+        m_commandType(commandType) {}
+
+  [[nodiscard]] auto commandType() const -> IndirectCommandType {
+    return m_commandType;
+  }
+};
+
 } // namespace info
 
-class Buffer : public Handle<VkBuffer> {
+class Buffer : public Handle<VkBuffer>, public Versioned {
 protected:
   RawRef<Device, VkDevice> m_device;
   Size m_size;
@@ -134,7 +161,7 @@ public:
       -> std::optional<Buffer>;
   auto destroy() -> void override;
 
-  auto size() -> VkDeviceSize { return m_size; }
+  auto size() const -> VkDeviceSize { return m_size; }
 
   auto getDevice() -> RawRef<Device, VkDevice> & { return m_device; }
 
@@ -165,6 +192,14 @@ public:
   [[nodiscard]] auto canCopyTo() const -> bool {
     return isBound() && (m_usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) != 0;
   }
+
+  [[nodiscard]] auto isIndirect() const -> bool {
+    return (m_usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) != 0;
+  }
+
+  [[nodiscard]] auto isStorage() const -> bool {
+    return (m_usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) != 0;
+  }
 };
 
 class IndexBuffer : public Buffer {
@@ -219,6 +254,57 @@ public:
   }
 };
 
+class IndirectBuffer : public Buffer {
+  IndirectCommandType m_commandType;
+
+  IndirectBuffer(VkBuffer buffer, Device &device, Size size,
+                 VkBufferUsageFlags usage,
+                 IndirectCommandType commandType) noexcept
+      : Buffer(buffer, device, size, usage), m_commandType(commandType) {}
+
+public:
+  IndirectBuffer(IndirectBuffer &&o) noexcept
+      : Buffer(std::move(o)), m_commandType(o.m_commandType) {}
+
+  static auto create(Device &device, vk::info::IndirectBufferCreate &createInfo)
+      -> std::optional<IndirectBuffer>;
+
+  [[nodiscard]] constexpr auto bufferTypeName() const -> const char * override {
+    return "IndirectBuffer";
+  }
+
+  [[nodiscard]] auto commandType() const -> IndirectCommandType {
+    return m_commandType;
+  }
+
+  [[nodiscard]] auto stride() const -> uint32_t {
+    return m_commandType.stride();
+  }
+
+  // Number of commands that fit in the buffer
+  [[nodiscard]] auto capacity() const -> uint32_t {
+    return static_cast<uint32_t>(static_cast<VkDeviceSize>(m_size) /
+                                 m_commandType.stride());
+  }
+
+  // Checks that `count` commands of `type` starting at `offset` can be read
+  // from this buffer, logging the reason if not.
+  [[nodiscard]] auto canRead(IndirectCommandType type, uint32_t count,
+                             VkDeviceSize offset) const -> bool;
+
+  // `canRead` plus the device requirements of an indirect draw of
+  // `drawCount` commands
+  [[nodiscard]] auto canDraw(IndirectCommandType type, uint32_t drawCount,
+                             VkDeviceSize offset) const -> bool;
+
+  // `canRead` plus the requirements of an indirect count draw reading its
+  // count from `countBuffer` at `countOffset`
+  [[nodiscard]] auto canDrawCount(IndirectCommandType type,
+                                  uint32_t maxDrawCount, VkDeviceSize offset,
+                                  const Buffer &countBuffer,
+                                  VkDeviceSize countOffset) const -> bool;
+};
+
 } // namespace vk
 
 template <>
@@ -1,11 +1,16 @@
 #include "buffer.hpp"
 
+#include "commands/bundle.hpp"
+#include "commands/stream.hpp"
 #include "device/device.hpp"
 #include "util/vk-logger.hpp"
 
 #include "descriptors.hpp"
 #include "pipeline/layout.hpp"
 #include "pipeline/pipeline.hpp"
+#include "queries/pool.hpp"
+#include "queries/statistics.hpp"
+#include "queries/timestamps.hpp"
 
 #include <optional>
 #include <span>
@@ -41,6 +46,8 @@ auto CommandBuffer::begin(info::CommandBufferBegin beginInfo) -> Encoder {
 auto Encoder::beginRenderPass(const VkRenderPassBeginInfo info,
                               const VkSubpassContents contents)
     -> Encoder::RenderPass {
+  flushBarriers();
+
   vkCmdBeginRenderPass(**commandBuffer, &info, contents);
 
   CommandBuffer::Encoder::RenderPass renderPass(*this);
@@ -50,6 +57,19 @@ auto Encoder::beginRenderPass(const VkRenderPassBeginInfo info,
   return renderPass;
 }
 
+auto Encoder::beginRendering(const info::RenderingInfo &info)
+    -> Encoder::RenderPass {
+  flushBarriers();
+
+  vkCmdBeginRendering(**commandBuffer, &info);
+
+  CommandBuffer::Encoder::RenderPass renderPass(*this, true);
+
+  activeRenderPass = renderPass.ref();
+
+  return renderPass;
+}
+
 void Encoder::RenderPass::bindPipeline(const Pipeline &pipeline) {
   if (!*this)
     return;
@@ -60,7 +80,11 @@ void Encoder::RenderPass::bindPipeline(const Pipeline &pipeline) {
 void Encoder::RenderPass::end() {
   if (!*this)
     return;
-  vkCmdEndRenderPass(getCmd());
+  if (m_dynamic) {
+    vkCmdEndRendering(getCmd());
+  } else {
+    vkCmdEndRenderPass(getCmd());
+  }
   encoder->value().activeRenderPass = std::nullopt;
   encoder = std::nullopt;
 }
@@ -178,6 +202,19 @@ void Encoder::RenderPass::draw(uint32_t vertexCount, uint32_t instanceCount,
   vkCmdDraw(getCmd(), vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
+void Encoder::RenderPass::beginQueryScope(QueryScopes &scopes,
+                                          std::string_view name) {
+  if (!*this)
+    return;
+  scopes.begin(getCmd(), name);
+}
+
+void Encoder::RenderPass::endQueryScope(QueryScopes &scopes) {
+  if (!*this)
+    return;
+  scopes.end(getCmd());
+}
+
 void Encoder::RenderPass::drawIndexed(uint32_t indexCount,
                                       uint32_t instanceCount,
                                       uint32_t firstIndex, int32_t vertexOffset,
@@ -188,9 +225,131 @@ void Encoder::RenderPass::drawIndexed(uint32_t indexCount,
                    vertexOffset, firstInstance);
 }
 
+void Encoder::RenderPass::drawIndirect(IndirectBuffer &buffer,
+                                       uint32_t drawCount,
+                                       VkDeviceSize offset) {
+  if (!*this || drawCount == 0)
+    return;
+
+  if (!buffer.canDraw(IndirectCommandType::Draw, drawCount, offset))
+    return;
+
+  vkCmdDrawIndirect(getCmd(), *buffer, offset, drawCount, buffer.stride());
+}
+
+void Encoder::RenderPass::drawIndexedIndirect(IndirectBuffer &buffer,
+                                              uint32_t drawCount,
+                                              VkDeviceSize offset) {
+  if (!*this || drawCount == 0)
+    return;
+
+  if (!buffer.canDraw(IndirectCommandType::DrawIndexed, drawCount, offset))
+    return;
+
+  vkCmdDrawIndexedIndirect(getCmd(), *buffer, offset, drawCount,
+                           buffer.stride());
+}
+
+void Encoder::RenderPass::drawIndirectCount(IndirectBuffer &buffer,
+                                            Buffer &countBuffer,
+                                            uint32_t maxDrawCount,
+                                            VkDeviceSize offset,
+                                            VkDeviceSize countOffset) {
+  if (!*this || maxDrawCount == 0)
+    return;
+
+  if (!buffer.canDrawCount(IndirectCommandType::Draw, maxDrawCount, offset,
+                           countBuffer, countOffset))
+    return;
+
+  vkCmdDrawIndirectCount(getCmd(), *buffer, offset, *countBuffer, countOffset,
+                         maxDrawCount, buffer.stride());
+}
+
+void Encoder::RenderPass::drawIndexedIndirectCount(IndirectBuffer &buffer,
+                                                   Buffer &countBuffer,
+                                                   uint32_t maxDrawCount,
+                                                   VkDeviceSize offset,
+                                                   VkDeviceSize countOffset) {
+  if (!*this || maxDrawCount == 0)
+    return;
+
+  if (!buffer.canDrawCount(IndirectCommandType::DrawIndexed, maxDrawCount,
+                           offset, countBuffer, countOffset))
+    return;
+
+  vkCmdDrawIndexedIndirectCount(getCmd(), *buffer, offset, *countBuffer,
+                                countOffset, maxDrawCount, buffer.stride());
+}
+
+void Encoder::RenderPass::pushConstants(ShaderStageFlags stages,
+                                        uint32_t offset, uint32_t size,
+                                        const void *data) {
+  if (!*this)
+    return;
+
+  if (!m_pipeline.has_value() || !m_pipeline.value().has_value()) {
+    Logger::error("No pipeline bound to render pass, cannot push constants.");
+    return;
+  }
+
+  auto &layout = m_pipeline.value()->layout();
+  if (!layout.canPushConstants(stages, offset, size))
+    return;
+
+  vkCmdPushConstants(getCmd(), layout, stages, offset, size, data);
+}
+
+void Encoder::RenderPass::execute(const CommandStream &stream) {
+  if (!*this)
+    return;
+
+  if (stream.hasRenderPassOps()) {
+    Logger::error("Cannot execute a command stream that begins or ends render "
+                  "passes inside a render pass.");
+    return;
+  }
+
+  if (stream.hasDispatches()) {
+    Logger::error("Cannot execute a command stream that dispatches compute "
+                  "work inside a render pass.");
+    return;
+  }
+
+  stream.replay(getCmd());
+  // The stream only records the raw handle, so the pipeline it left bound
+  // has to be bound again on the render pass before it is used
+  if (stream.bindsPipeline()) {
+    m_pipeline = std::nullopt;
+  }
+}
+
+void Encoder::RenderPass::execute(const CommandBundle &bundle) {
+  if (!*this)
+    return;
+
+  if (!bundle.isReady()) {
+    Logger::error("Command bundle was not prepared for this frame");
+    return;
+  }
+
+  if (!bundle.insideRenderPass()) {
+    Logger::error("Command bundle was not recorded for use in a render pass");
+    return;
+  }
+
+  VkCommandBuffer secondary = bundle.commandBuffer();
+  vkCmdExecuteCommands(getCmd(), 1, &secondary);
+  // Bound state is undefined after executing secondary command buffers
+  m_pipeline = std::nullopt;
+}
+
 void Encoder::copyBuffer(Buffer &src, Buffer &dst, const VkBufferCopy &region) {
   if (!*this)
     return;
+
+  flushBarriers();
+
   vkCmdCopyBuffer(**commandBuffer, *src, *dst, 1, &region);
 }
 
@@ -198,14 +357,285 @@ void Encoder::copyBuffer(Buffer &src, Buffer &dst,
                          const std::span<vk::BufferCopy> &regions) {
   if (!*this)
     return;
+
+  flushBarriers();
+
   vkCmdCopyBuffer(**commandBuffer, *src, *dst,
                   static_cast<uint32_t>(regions.size()), regions.data());
 }
 
+void Encoder::execute(const CommandStream &stream) {
+  if (!*this)
+    return;
+
+  flushBarriers();
+
+  if (activeRenderPass.has_value()) {
+    Logger::error("Cannot execute a command stream on the encoder while a "
+                  "render pass is active, use RenderPass::execute instead.");
+    return;
+  }
+
+  stream.replay(**commandBuffer);
+  if (stream.bindsPipeline()) {
+    m_pipeline = std::nullopt;
+  }
+}
+
+void Encoder::execute(const CommandBundle &bundle) {
+  if (!*this)
+    return;
+
+  flushBarriers();
+
+  if (activeRenderPass.has_value()) {
+    Logger::error("Cannot execute a command bundle on the encoder while a "
+                  "render pass is active, use RenderPass::execute instead.");
+    return;
+  }
+
+  if (!bundle.isReady()) {
+    Logger::error("Command bundle was not prepared for this frame");
+    return;
+  }
+
+  if (bundle.insideRenderPass()) {
+    Logger::error("Command bundle was recorded for use in a render pass");
+    return;
+  }
+
+  VkCommandBuffer secondary = bundle.commandBuffer();
+  vkCmdExecuteCommands(**commandBuffer, 1, &secondary);
+  // Bound state is undefined after executing secondary command buffers
+  m_pipeline = std::nullopt;
+}
+
+void Encoder::flushBarriers() {
+  if (!*this || m_barriers.empty())
+    return;
+
+  if (activeRenderPass.has_value()) {
+    // Held until the render pass ends, barriers inside one are restricted to
+    // self-dependencies.
+    return;
+  }
+
+  m_barriers.flush(**commandBuffer);
+}
+
+void Encoder::resetQueries(QueryPool &pool, uint32_t firstQuery,
+                           uint32_t queryCount) {
+  if (!*this)
+    return;
+
+  if (activeRenderPass.has_value()) {
+    Logger::error("Cannot reset queries inside a render pass.");
+    return;
+  }
+
+  vkCmdResetQueryPool(**commandBuffer, pool, firstQuery, queryCount);
+}
+
+void Encoder::writeTimestamp(QueryPool &pool, uint32_t query,
+                             VkPipelineStageFlags2 stage) {
+  if (!*this)
+    return;
+
+  flushBarriers();
+
+  vkCmdWriteTimestamp2(**commandBuffer, stage, pool, query);
+}
+
+void Encoder::beginTimedFrame(GpuTimer &timer, uint64_t frameNumber) {
+  if (!*this)
+    return;
+
+  if (activeRenderPass.has_value()) {
+    Logger::error("Cannot begin a timed frame inside a render pass.");
+    return;
+  }
+
+  m_timer = &timer;
+  m_timer->beginFrame(**commandBuffer, frameNumber);
+}
+
+void Encoder::beginTimestampScope(std::string_view name) {
+  if (!*this || m_timer == nullptr)
+    return;
+
+  flushBarriers();
+
+  m_timer->beginScope(**commandBuffer, name);
+}
+
+void Encoder::endTimestampScope() {
+  if (!*this || m_timer == nullptr)
+    return;
+
+  flushBarriers();
+
+  m_timer->endScope(**commandBuffer);
+}
+
+void Encoder::bindPipeline(const Pipeline &pipeline) {
+  if (!*this)
+    return;
+
+  if (activeRenderPass.has_value()) {
+    Logger::error("Cannot bind a pipeline on the encoder while a render pass "
+                  "is active, use RenderPass::bindPipeline instead.");
+    return;
+  }
+
+  m_pipeline = pipeline.ref();
+  vkCmdBindPipeline(**commandBuffer, pipeline.bindPoint(), pipeline);
+}
+
+void Encoder::bindDescriptorSet(const DescriptorSet &set,
+                                const std::span<uint32_t> dynamicOffsets) {
+  if (!*this)
+    return;
+
+  if (!m_pipeline.has_value() || !m_pipeline.value().has_value()) {
+    Logger::error("No pipeline bound to encoder, cannot bind descriptor set.");
+    return;
+  }
+
+  auto &pipeline = m_pipeline.value().value();
+
+  VkDescriptorSet rawSet = set;
+
+  vkCmdBindDescriptorSets(**commandBuffer, pipeline.bindPoint(),
+                          pipeline.layout(), 0, 1, &rawSet,
+                          static_cast<uint32_t>(dynamicOffsets.size()),
+                          dynamicOffsets.data());
+}
+
+void Encoder::bindDescriptorSets(const std::span<DescriptorSet> &sets,
+                                 uint32_t firstSet,
+                                 const std::span<uint32_t> dynamicOffsets) {
+  if (!*this)
+    return;
+
+  if (!m_pipeline.has_value() || !m_pipeline.value().has_value()) {
+    Logger::error("No pipeline bound to encoder, cannot bind descriptor sets.");
+    return;
+  }
+
+  auto &pipeline = m_pipeline.value().value();
+
+  std::vector<VkDescriptorSet> rawSets(sets.size());
+  for (size_t i = 0; i < sets.size(); i++) {
+    rawSets[i] = *sets[i];
+  }
+
+  vkCmdBindDescriptorSets(**commandBuffer, pipeline.bindPoint(),
+                          pipeline.layout(), firstSet,
+                          static_cast<uint32_t>(rawSets.size()),
+                          rawSets.data(),
+                          static_cast<uint32_t>(dynamicOffsets.size()),
+                          dynamicOffsets.data());
+}
+
+auto Encoder::canDispatch() const -> bool {
+  if (activeRenderPass.has_value()) {
+    Logger::error("Cannot dispatch compute work inside a render pass.");
+    return false;
+  }
+
+  if (!m_pipeline.has_value() || !m_pipeline.value().has_value() ||
+      m_pipeline.value()->bindPoint() != VK_PIPELINE_BIND_POINT_COMPUTE) {
+    Logger::error("No compute pipeline bound, cannot dispatch.");
+    return false;
+  }
+
+  return true;
+}
+
+void Encoder::dispatch(uint32_t groupCountX, uint32_t groupCountY,
+                       uint32_t groupCountZ) {
+  if (!*this || !canDispatch())
+    return;
+
+  flushBarriers();
+
+  if (groupCountX == 0 || groupCountY == 0 || groupCountZ == 0)
+    return;
+
+  vkCmdDispatch(**commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void Encoder::dispatchIndirect(IndirectBuffer &buffer, VkDeviceSize offset) {
+  if (!*this || !canDispatch())
+    return;
+
+  flushBarriers();
+
+  if (!buffer.canRead(IndirectCommandType::Dispatch, 1, offset))
+    return;
+
+  vkCmdDispatchIndirect(**commandBuffer, *buffer, offset);
+}
+
+void Encoder::pushConstants(ShaderStageFlags stages, uint32_t offset,
+                            uint32_t size, const void *data) {
+  if (!*this)
+    return;
+
+  if (!m_pipeline.has_value() || !m_pipeline.value().has_value()) {
+    Logger::error("No pipeline bound to encoder, cannot push constants.");
+    return;
+  }
+
+  auto &layout = m_pipeline.value()->layout();
+  if (!layout.canPushConstants(stages, offset, size))
+    return;
+
+  vkCmdPushConstants(**commandBuffer, layout, stages, offset, size, data);
+}
+
+void Encoder::fillBuffer(Buffer &dst, uint32_t data, VkDeviceSize offset,
+                         VkDeviceSize size) {
+  if (!*this)
+    return;
+
+  flushBarriers();
+
+  if (!dst.canCopyTo()) {
+    Logger::error("Buffer is not a transfer destination");
+    return;
+  }
+
+  vkCmdFillBuffer(**commandBuffer, *dst, offset, size, data);
+}
+
+void Encoder::pipelineBarrier(
+    VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
+    std::span<const VkMemoryBarrier> memoryBarriers,
+    std::span<const VkBufferMemoryBarrier> bufferBarriers,
+    std::span<const VkImageMemoryBarrier> imageBarriers,
+    VkDependencyFlags dependencyFlags) {
+  if (!*this)
+    return;
+
+  flushBarriers();
+
+  vkCmdPipelineBarrier(**commandBuffer, srcStageMask, dstStageMask,
+                       dependencyFlags,
+                       static_cast<uint32_t>(memoryBarriers.size()),
+                       memoryBarriers.data(),
+                       static_cast<uint32_t>(bufferBarriers.size()),
+                       bufferBarriers.data(),
+                       static_cast<uint32_t>(imageBarriers.size()),
+                       imageBarriers.data());
+}
+
 auto Encoder::end() -> VkResult {
   if (!*this)
     return VK_SUCCESS;
 
+  flushBarriers();
+
   auto res = vkEndCommandBuffer(**commandBuffer);
   commandBuffer.value()->encoder = std::nullopt;
   commandBuffer = std::nullopt;
@@ -6,7 +6,10 @@
 #include "buffers.hpp"
 #include "device/device.hpp"
 #include "device/memory.hpp"
+#include "enums/shader-stage.hpp"
+#include "pipeline/layout.hpp"
 #include "structs/clearValue.hpp"
+#include "sync/barrier.hpp"
 
 #include "util/vk-logger.hpp"
 
@@ -14,14 +17,22 @@
 #include <cstdint>
 #include <optional>
 #include <span>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 
 namespace vk {
 class Pipeline;
 class DescriptorSet;
+class CommandStream;
+class CommandBundle;
 class Buffer;
 class VertexBuffer;
 class IndexBuffer;
+class IndirectBuffer;
+class QueryPool;
+class GpuTimer;
+class QueryScopes;
 
 namespace info {
 class CommandBufferBegin : public VkCommandBufferBeginInfo {
@@ -48,6 +59,13 @@ public:
     flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
     return *this;
   }
+
+  // Required for secondary command buffers, must outlive the begin call
+  auto setInheritance(const VkCommandBufferInheritanceInfo *inheritance)
+      -> CommandBufferBegin & {
+    pInheritanceInfo = inheritance;
+    return *this;
+  }
 };
 
 class RenderPassBegin : public VkRenderPassBeginInfo {
@@ -89,6 +107,119 @@ public:
   }
 };
 
+class RenderingAttachment : public VkRenderingAttachmentInfo {
+public:
+  RenderingAttachment(VkImageView imageView, VkImageLayout layout)
+      : VkRenderingAttachmentInfo{
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .pNext = nullptr,
+            .imageView = imageView,
+            .imageLayout = layout,
+            .resolveMode = VK_RESOLVE_MODE_NONE,
+            .resolveImageView = VK_NULL_HANDLE,
+            .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = {}} {}
+
+  auto clear(const ClearValue &value) -> RenderingAttachment & {
+    loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    clearValue = value;
+    return *this;
+  }
+
+  auto setLoadOp(VkAttachmentLoadOp op) -> RenderingAttachment & {
+    loadOp = op;
+    return *this;
+  }
+
+  auto setStoreOp(VkAttachmentStoreOp op) -> RenderingAttachment & {
+    storeOp = op;
+    return *this;
+  }
+
+  auto resolveTo(VkImageView view, VkImageLayout layout,
+                 VkResolveModeFlagBits mode = VK_RESOLVE_MODE_AVERAGE_BIT)
+      -> RenderingAttachment & {
+    resolveMode = mode;
+    resolveImageView = view;
+    resolveImageLayout = layout;
+    return *this;
+  }
+};
+
+// Attachments for dynamic rendering, chosen at record time instead of through
+// a `RenderPass` and `Framebuffer`.
+class RenderingInfo : public VkRenderingInfo {
+  std::vector<RenderingAttachment> m_colorAttachments;
+  std::optional<RenderingAttachment> m_depthAttachment;
+  std::optional<RenderingAttachment> m_stencilAttachment;
+
+  void setupAttachments() {
+    colorAttachmentCount = static_cast<uint32_t>(m_colorAttachments.size());
+    pColorAttachments = m_colorAttachments.data();
+    pDepthAttachment =
+        m_depthAttachment.has_value() ? &m_depthAttachment.value() : nullptr;
+    pStencilAttachment = m_stencilAttachment.has_value()
+                             ? &m_stencilAttachment.value()
+                             : nullptr;
+  }
+
+public:
+  RenderingInfo(VkRect2D area, uint32_t layers = 1)
+      : VkRenderingInfo{.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                        .pNext = nullptr,
+                        .flags = 0,
+                        .renderArea = area,
+                        .layerCount = layers,
+                        .viewMask = 0,
+                        .colorAttachmentCount = 0,
+                        .pColorAttachments = nullptr,
+                        .pDepthAttachment = nullptr,
+                        .pStencilAttachment = nullptr} {}
+
+  auto addColorAttachment(const RenderingAttachment &attachment)
+      -> RenderingInfo & {
+    m_colorAttachments.push_back(attachment);
+    setupAttachments();
+    return *this;
+  }
+
+  auto setDepthAttachment(const RenderingAttachment &attachment)
+      -> RenderingInfo & {
+    m_depthAttachment = attachment;
+    setupAttachments();
+    return *this;
+  }
+
+  auto setStencilAttachment(const RenderingAttachment &attachment)
+      -> RenderingInfo & {
+    m_stencilAttachment = attachment;
+    setupAttachments();
+    return *this;
+  }
+
+  auto setFlags(VkRenderingFlags renderingFlags) -> RenderingInfo & {
+    flags = renderingFlags;
+    return *this;
+  }
+
+  RenderingInfo(const RenderingInfo &o)
+      : VkRenderingInfo{o}, m_colorAttachments(o.m_colorAttachments),
+        m_depthAttachment(o.m_depthAttachment),
+        m_stencilAttachment(o.m_stencilAttachment) {
+    setupAttachments();
+  }
+
+  RenderingInfo(RenderingInfo &&o) noexcept
+      : VkRenderingInfo{o}, m_colorAttachments(std::move(o.m_colorAttachments)),
+        m_depthAttachment(std::move(o.m_depthAttachment)),
+        m_stencilAttachment(std::move(o.m_stencilAttachment)) {
+    o.setupAttachments();
+    setupAttachments();
+  }
+};
+
 } // namespace info
 
 class CommandBuffer : public Handle<VkCommandBuffer>,
@@ -97,6 +228,12 @@ class CommandBuffer : public Handle<VkCommandBuffer>,
 public:
   class Encoder : public Refable<Encoder> {
     std::optional<Reference<CommandBuffer>> commandBuffer;
+    // Pipeline bound outside of a render pass, e.g. a compute pipeline
+    std::optional<RawRef<Pipeline, VkPipeline>> m_pipeline;
+    BarrierBatch m_barriers;
+    GpuTimer *m_timer = nullptr;
+
+    [[nodiscard]] auto canDispatch() const -> bool;
 
   public:
     Encoder(CommandBuffer &commandBuffer)
@@ -107,6 +244,8 @@ public:
     auto operator=(const Encoder &) -> Encoder & = delete;
     Encoder(Encoder &&o) noexcept
         : Refable(std::move(o)), commandBuffer(std::move(o.commandBuffer)),
+          m_pipeline(std::move(o.m_pipeline)),
+          m_barriers(std::move(o.m_barriers)), m_timer(o.m_timer),
           activeRenderPass(std::move(o.activeRenderPass)) {}
 
     operator bool() const { return commandBuffer.has_value(); }
@@ -114,6 +253,8 @@ public:
     class RenderPass : public Refable<RenderPass> {
       std::optional<Reference<Encoder>> encoder;
       std::optional<RawRef<Pipeline, VkPipeline>> m_pipeline;
+      // Started with `beginRendering` rather than `beginRenderPass`
+      bool m_dynamic = false;
 
       [[nodiscard]] inline auto getCmd() const -> CommandBuffer & {
         return encoder->value().commandBuffer.value().value();
@@ -121,11 +262,13 @@ public:
 
     public:
       RenderPass() = delete;
-      RenderPass(Encoder &encoder) : Refable(), encoder(encoder.ref()) {}
+      RenderPass(Encoder &encoder, bool dynamic = false)
+          : Refable(), encoder(encoder.ref()), m_dynamic(dynamic) {}
       RenderPass(const RenderPass &) = delete;
       auto operator=(const RenderPass &) -> RenderPass & = delete;
       RenderPass(RenderPass &&o) noexcept
-          : Refable(std::move(o)), encoder(std::move(o.encoder)) {}
+          : Refable(std::move(o)), encoder(std::move(o.encoder)),
+            m_pipeline(std::move(o.m_pipeline)), m_dynamic(o.m_dynamic) {}
       operator bool() const { return encoder.has_value(); }
 
       void bindPipeline(const vk::Pipeline &pipeline);
@@ -155,6 +298,55 @@ public:
                        uint32_t firstIndex = 0, int32_t vertexOffset = 0,
                        uint32_t firstInstance = 0);
 
+      void drawIndirect(IndirectBuffer &buffer, uint32_t drawCount,
+                        VkDeviceSize offset = 0);
+
+      void drawIndexedIndirect(IndirectBuffer &buffer, uint32_t drawCount,
+                               VkDeviceSize offset = 0);
+
+      // The draw count is read from `countBuffer` at `countOffset` and clamped
+      // to `maxDrawCount`. Requires Vulkan 1.2 with `drawIndirectCount`
+      // enabled.
+      void drawIndirectCount(IndirectBuffer &buffer, Buffer &countBuffer,
+                             uint32_t maxDrawCount, VkDeviceSize offset = 0,
+                             VkDeviceSize countOffset = 0);
+
+      void drawIndexedIndirectCount(IndirectBuffer &buffer, Buffer &countBuffer,
+                                    uint32_t maxDrawCount,
+                                    VkDeviceSize offset = 0,
+                                    VkDeviceSize countOffset = 0);
+
+      // Untyped push, checked against the bound pipeline's layout and the
+      // device's `maxPushConstantsSize`.
+      void pushConstants(ShaderStageFlags stages, uint32_t offset,
+                         uint32_t size, const void *data);
+
+      template <typename T>
+      void pushConstants(ShaderStageFlags stages, uint32_t offset,
+                         const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(sizeof(T) % 4 == 0,
+                      "Push constant blocks must be a multiple of 4 bytes");
+        static_assert(sizeof(T) <= MinPushConstantsSize,
+                      "Push constant block may exceed the device limit, use "
+                      "the untyped overload");
+        pushConstants(stages, offset, sizeof(T), &value);
+      }
+
+      // Pipeline statistics or occlusion query around the following draws.
+      // A scope must end within the same subpass it began in.
+      void beginQueryScope(QueryScopes &scopes, std::string_view name);
+      void endQueryScope(QueryScopes &scopes);
+
+      // Replay a recorded stream into this render pass. The stream must not
+      // begin or end render passes itself.
+      void execute(const CommandStream &stream);
+
+      // Execute a prepared bundle recorded for this render pass. The pass must
+      // have been begun with secondary command buffer contents. The pipeline
+      // has to be bound again afterwards.
+      void execute(const CommandBundle &bundle);
+
       void end();
       ~RenderPass();
     };
@@ -165,13 +357,95 @@ public:
                          const VkSubpassContents contents =
                              VK_SUBPASS_CONTENTS_INLINE) -> RenderPass;
 
+    // Dynamic rendering, requires Vulkan 1.3 with `dynamicRendering` enabled.
+    // Pipelines used inside must be created with `PipelineRenderingCreate`.
+    auto beginRendering(const info::RenderingInfo &info) -> RenderPass;
+
     void copyBuffer(Buffer &src, Buffer &dst, const VkBufferCopy &region);
     void copyBuffer(Buffer &src, Buffer &dst,
                     const std::span<BufferCopy> &regions);
 
+    void execute(const CommandStream &stream);
+    // Execute a prepared bundle recorded for use outside of render passes.
+    // The pipeline has to be bound again afterwards.
+    void execute(const CommandBundle &bundle);
+
+    // Barriers queued here are merged and recorded in one
+    // vkCmdPipelineBarrier2 right before the next encoder command (copy,
+    // dispatch, render pass begin...) or when the encoder ends. Barriers
+    // queued inside a render pass are held until it ends.
+    auto barriers() -> BarrierBatch & { return m_barriers; }
+
+    void flushBarriers();
+
+    void resetQueries(QueryPool &pool, uint32_t firstQuery,
+                      uint32_t queryCount);
+    void writeTimestamp(QueryPool &pool, uint32_t query,
+                        VkPipelineStageFlags2 stage =
+                            VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT);
+
+    // Route timestamp scopes recorded with this encoder to `timer` for frame
+    // `frameNumber`. Must be called outside of a render pass.
+    void beginTimedFrame(GpuTimer &timer, uint64_t frameNumber);
+
+    // Scopes nest and may span render passes. Without a timed frame they are
+    // ignored.
+    void beginTimestampScope(std::string_view name);
+    void endTimestampScope();
+
+    void bindPipeline(const vk::Pipeline &pipeline);
+
+    void bindDescriptorSet(const DescriptorSet &set,
+                           const std::span<uint32_t> dynamicOffsets = {});
+    void bindDescriptorSets(const std::span<DescriptorSet> &sets,
+                            uint32_t firstSet = 0,
+                            const std::span<uint32_t> dynamicOffsets = {});
+
+    void dispatch(uint32_t groupCountX, uint32_t groupCountY = 1,
+                  uint32_t groupCountZ = 1);
+
+    // Group counts are read from a `Dispatch` indirect buffer at `offset`
+    void dispatchIndirect(IndirectBuffer &buffer, VkDeviceSize offset = 0);
+
+    // Untyped push, checked against the bound pipeline's layout and the
+    // device's `maxPushConstantsSize`.
+    void pushConstants(ShaderStageFlags stages, uint32_t offset,
+                       uint32_t size, const void *data);
+
+    template <typename T>
+    void pushConstants(ShaderStageFlags stages, uint32_t offset,
+                       const T &value) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      static_assert(sizeof(T) % 4 == 0,
+                    "Push constant blocks must be a multiple of 4 bytes");
+      static_assert(sizeof(T) <= MinPushConstantsSize,
+                    "Push constant block may exceed the device limit, use "
+                    "the untyped overload");
+      pushConstants(stages, offset, sizeof(T), &value);
+    }
+
+    // Fill `size` bytes of `dst` at `offset` with the repeated 4 byte `data`
+    void fillBuffer(Buffer &dst, uint32_t data, VkDeviceSize offset = 0,
+                    VkDeviceSize size = VK_WHOLE_SIZE);
+
+    void pipelineBarrier(VkPipelineStageFlags srcStageMask,
+                         VkPipelineStageFlags dstStageMask,
+                         std::span<const VkMemoryBarrier> memoryBarriers = {},
+                         std::span<const VkBufferMemoryBarrier> bufferBarriers =
+                             {},
+                         std::span<const VkImageMemoryBarrier> imageBarriers =
+                             {},
+                         VkDependencyFlags dependencyFlags = 0);
+
     struct TemporaryStaging {
       Buffer buf;
       DeviceMemory memory;
+
+      // Lets a `DeletionQueue` retire the staging once the copy completes
+      void release() {
+        buf.release();
+        memory.release();
+      }
     };
 
     template <typename T>
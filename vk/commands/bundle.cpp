@@ -0,0 +1,95 @@
+#include "bundle.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "commands/pool.hpp"
+
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+auto CommandBundle::create(const CommandPool &pool, uint32_t framesInFlight,
+                           info::CommandBufferInheritance inheritance,
+                           Recorder recorder)
+    -> std::optional<CommandBundle> {
+  if (framesInFlight == 0) {
+    Logger::error("A command bundle needs at least one frame in flight");
+    return std::nullopt;
+  }
+
+  if (!recorder) {
+    Logger::error("A command bundle needs a recorder");
+    return std::nullopt;
+  }
+
+  auto buffers = pool.allocBuffers(framesInFlight, true);
+  if (!buffers.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<Slot> slots;
+  slots.reserve(framesInFlight);
+  for (auto &buffer : buffers.value()) {
+    slots.push_back({.commandBuffer = buffer});
+  }
+
+  return CommandBundle(std::move(slots), std::move(inheritance),
+                       std::move(recorder));
+}
+
+auto CommandBundle::rebuildStream() -> bool {
+  m_stream.clear();
+  m_stream.trackDependencies();
+  m_recorder(m_stream);
+
+  m_generation++;
+  m_dirty = false;
+
+  if (m_inheritance.insideRenderPass() &&
+      (m_stream.hasRenderPassOps() || m_stream.hasDispatches())) {
+    Logger::error("Command bundles executed inside a render pass cannot begin "
+                  "render passes or dispatch compute work");
+    return false;
+  }
+
+  return true;
+}
+
+auto CommandBundle::prepare(uint64_t frameNumber) -> bool {
+  m_current = static_cast<uint32_t>(frameNumber % m_slots.size());
+  m_ready = false;
+
+  if (m_dirty || !m_stream.isCurrent()) {
+    Logger::debug("Re-recording command bundle");
+    if (!rebuildStream()) {
+      m_dirty = true;
+      return false;
+    }
+  }
+
+  auto &slot = m_slots[m_current];
+  if (slot.generation != m_generation) {
+    info::CommandBufferBegin beginInfo{};
+    beginInfo.setInheritance(&m_inheritance);
+    if (m_inheritance.insideRenderPass()) {
+      beginInfo.renderPassContinue();
+    }
+
+    auto encoder = slot.commandBuffer.begin(beginInfo);
+    encoder.execute(m_stream);
+    auto result = encoder.end();
+    if (result != VK_SUCCESS) {
+      Logger::error("Failed to record command bundle: {}",
+                    static_cast<int>(result));
+      slot.generation = 0;
+      return false;
+    }
+
+    slot.generation = m_generation;
+  }
+
+  m_ready = true;
+  return true;
+}
+} // namespace vk
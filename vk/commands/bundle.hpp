@@ -0,0 +1,191 @@
+#pragma once
+
+#include "commands/buffer.hpp"
+#include "commands/stream.hpp"
+#include "pipeline/graphics.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace vk {
+class CommandPool;
+
+namespace info {
+// State a secondary command buffer inherits from the primary it is executed
+// in. Default constructed it executes outside of any render pass.
+class CommandBufferInheritance : public VkCommandBufferInheritanceInfo {
+  VkCommandBufferInheritanceRenderingInfo m_rendering;
+  std::vector<VkFormat> m_colorFormats;
+  bool m_dynamic = false;
+
+  void setupRendering() {
+    m_rendering.colorAttachmentCount =
+        static_cast<uint32_t>(m_colorFormats.size());
+    m_rendering.pColorAttachmentFormats = m_colorFormats.data();
+    pNext = m_dynamic ? &m_rendering : nullptr;
+  }
+
+public:
+  CommandBufferInheritance()
+      : VkCommandBufferInheritanceInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            .pNext = nullptr,
+            .renderPass = VK_NULL_HANDLE,
+            .subpass = 0,
+            .framebuffer = VK_NULL_HANDLE,
+            .occlusionQueryEnable = VK_FALSE,
+            .queryFlags = 0,
+            .pipelineStatistics = 0},
+        m_rendering{
+            .sType =
+                VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .viewMask = 0,
+            .colorAttachmentCount = 0,
+            .pColorAttachmentFormats = nullptr,
+            .depthAttachmentFormat = VK_FORMAT_UNDEFINED,
+            .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT} {}
+
+  // Inside `subpass` of a render pass begun with
+  // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. The framebuffer is optional.
+  CommandBufferInheritance(VkRenderPass pass, uint32_t subpassIndex = 0,
+                           VkFramebuffer framebufferHandle = VK_NULL_HANDLE)
+      : CommandBufferInheritance() {
+    renderPass = pass;
+    subpass = subpassIndex;
+    framebuffer = framebufferHandle;
+  }
+
+  // Inside dynamic rendering begun with
+  // VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT, using the same
+  // attachment formats the pipelines were created with.
+  CommandBufferInheritance(const PipelineRenderingCreate &formats,
+                           VkSampleCountFlagBits samples =
+                               VK_SAMPLE_COUNT_1_BIT)
+      : CommandBufferInheritance() {
+    m_colorFormats.assign(formats.pColorAttachmentFormats,
+                          formats.pColorAttachmentFormats +
+                              formats.colorAttachmentCount);
+    m_rendering.viewMask = formats.viewMask;
+    m_rendering.depthAttachmentFormat = formats.depthAttachmentFormat;
+    m_rendering.stencilAttachmentFormat = formats.stencilAttachmentFormat;
+    m_rendering.rasterizationSamples = samples;
+    m_dynamic = true;
+    setupRendering();
+  }
+
+  CommandBufferInheritance(const CommandBufferInheritance &o)
+      : VkCommandBufferInheritanceInfo{o}, m_rendering(o.m_rendering),
+        m_colorFormats(o.m_colorFormats), m_dynamic(o.m_dynamic) {
+    setupRendering();
+  }
+
+  CommandBufferInheritance(CommandBufferInheritance &&o) noexcept
+      : VkCommandBufferInheritanceInfo{o}, m_rendering(o.m_rendering),
+        m_colorFormats(std::move(o.m_colorFormats)), m_dynamic(o.m_dynamic) {
+    o.setupRendering();
+    setupRendering();
+  }
+
+  auto operator=(const CommandBufferInheritance &o)
+      -> CommandBufferInheritance & {
+    if (this != &o) {
+      VkCommandBufferInheritanceInfo::operator=(o);
+      m_rendering = o.m_rendering;
+      m_colorFormats = o.m_colorFormats;
+      m_dynamic = o.m_dynamic;
+      setupRendering();
+    }
+    return *this;
+  }
+
+  [[nodiscard]] auto insideRenderPass() const -> bool {
+    return m_dynamic || renderPass != VK_NULL_HANDLE;
+  }
+};
+} // namespace info
+
+// Static work recorded once into secondary command buffers and executed every
+// frame with `execute(CommandBundle &)`.
+//
+// The commands come from `recorder`, which writes into a dependency tracking
+// `CommandStream`. `prepare` re-runs it only when a pipeline, buffer or
+// descriptor set it referenced was destroyed or changed, or after
+// `invalidate`, so the recorder must look its objects up again rather than
+// capture ones that may be replaced.
+//
+// Each frame in flight owns a secondary command buffer, which is re-recorded
+// from the current stream the next time its slot comes round. Slots must not
+// be prepared while the frame that last used them is still executing, and the
+// pool must allow resetting individual command buffers.
+class CommandBundle {
+public:
+  using Recorder = std::function<void(CommandStream &)>;
+
+private:
+  struct Slot {
+    CommandBuffer commandBuffer;
+    // Stream generation last recorded into the buffer, 0 if never
+    uint64_t generation = 0;
+  };
+
+  std::vector<Slot> m_slots;
+  info::CommandBufferInheritance m_inheritance;
+  Recorder m_recorder;
+
+  CommandStream m_stream;
+  uint64_t m_generation = 0;
+  bool m_dirty = true;
+
+  uint32_t m_current = 0;
+  bool m_ready = false;
+
+  CommandBundle(std::vector<Slot> &&slots,
+                info::CommandBufferInheritance &&inheritance,
+                Recorder &&recorder)
+      : m_slots(std::move(slots)), m_inheritance(std::move(inheritance)),
+        m_recorder(std::move(recorder)) {}
+
+  auto rebuildStream() -> bool;
+
+public:
+  static auto create(const CommandPool &pool, uint32_t framesInFlight,
+                     info::CommandBufferInheritance inheritance,
+                     Recorder recorder) -> std::optional<CommandBundle>;
+
+  CommandBundle(CommandBundle &&o) noexcept = default;
+
+  // Force the recorder to run again on the next `prepare`
+  void invalidate() { m_dirty = true; }
+
+  // The inheritance is baked into the recorded buffers, so changing it
+  // re-records every slot.
+  void setInheritance(const info::CommandBufferInheritance &inheritance) {
+    m_inheritance = inheritance;
+    m_generation++;
+  }
+
+  // Select slot `frameNumber % framesInFlight` and bring it up to date.
+  // Returns false if the bundle cannot be executed this frame.
+  auto prepare(uint64_t frameNumber) -> bool;
+
+  [[nodiscard]] auto isReady() const -> bool { return m_ready; }
+
+  [[nodiscard]] auto insideRenderPass() const -> bool {
+    return m_inheritance.insideRenderPass();
+  }
+
+  // Secondary command buffer of the prepared slot
+  [[nodiscard]] auto commandBuffer() const -> VkCommandBuffer {
+    return *m_slots[m_current].commandBuffer;
+  }
+
+  // Incremented whenever the recorded commands or inheritance change
+  [[nodiscard]] auto generation() const -> uint64_t { return m_generation; }
+};
+} // namespace vk
@@ -82,6 +82,11 @@ public:
   static auto create(Device &device, info::CommandPoolCreate info)
       -> std::optional<CommandPool>;
 
+  // Reset every command buffer allocated from the pool at once
+  auto reset(VkCommandPoolResetFlags flags = 0) -> VkResult {
+    return vkResetCommandPool(device, m_handle, flags);
+  }
+
   [[nodiscard]] auto allocBuffer(bool secondary = false) const
       -> std::optional<CommandBuffer>;
   [[nodiscard]] auto allocBuffers(uint32_t count, bool secondary = false) const
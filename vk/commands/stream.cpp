@@ -0,0 +1,573 @@
+#include "stream.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "buffers.hpp"
+#include "descriptors.hpp"
+#include "pipeline/layout.hpp"
+#include "pipeline/pipeline.hpp"
+
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+auto CommandStream::clear() -> void {
+  m_bytes.clear();
+  m_commandCount = 0;
+  m_hasRenderPassOps = false;
+  m_hasDispatches = false;
+  m_bindsPipeline = false;
+  m_bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  m_layout = nullptr;
+  m_dependencies.clear();
+}
+
+auto CommandStream::isCurrent() const -> bool {
+  for (const auto &dependency : m_dependencies) {
+    if (!dependency.isCurrent()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto CommandStream::append(const CommandStream &other) -> CommandStream & {
+  m_bytes.insert(m_bytes.end(), other.m_bytes.begin(), other.m_bytes.end());
+  m_commandCount += other.m_commandCount;
+  m_hasRenderPassOps |= other.m_hasRenderPassOps;
+  m_hasDispatches |= other.m_hasDispatches;
+  m_bindsPipeline |= other.m_bindsPipeline;
+  m_dependencies.insert(m_dependencies.end(), other.m_dependencies.begin(),
+                        other.m_dependencies.end());
+
+  if (other.m_layout != nullptr) {
+    m_bindPoint = other.m_bindPoint;
+    m_layout = other.m_layout;
+  }
+
+  return *this;
+}
+
+void CommandStream::beginRenderPass(const VkRenderPassBeginInfo &info,
+                                    const VkSubpassContents contents) {
+  stream::BeginRenderPass args{.renderPass = info.renderPass,
+                               .framebuffer = info.framebuffer,
+                               .renderArea = info.renderArea,
+                               .contents = contents,
+                               .clearValueCount = info.clearValueCount};
+
+  record(stream::Op::BeginRenderPass, args,
+         std::span<const VkClearValue>(info.pClearValues,
+                                       info.clearValueCount));
+  m_hasRenderPassOps = true;
+}
+
+void CommandStream::endRenderPass() {
+  record(stream::Op::EndRenderPass, uint32_t{0});
+  m_hasRenderPassOps = true;
+}
+
+void CommandStream::beginRendering(const VkRenderingInfo &info) {
+  auto attachments = [](const VkRenderingAttachmentInfo *data, size_t count) {
+    std::vector<VkRenderingAttachmentInfo> copy(data, data + count);
+    for (auto &attachment : copy) {
+      attachment.pNext = nullptr;
+    }
+    return copy;
+  };
+
+  auto color = attachments(info.pColorAttachments, info.colorAttachmentCount);
+  auto depth = attachments(info.pDepthAttachment,
+                           info.pDepthAttachment != nullptr ? 1 : 0);
+  auto stencil = attachments(info.pStencilAttachment,
+                             info.pStencilAttachment != nullptr ? 1 : 0);
+
+  stream::BeginRendering args{
+      .flags = info.flags,
+      .renderArea = info.renderArea,
+      .layerCount = info.layerCount,
+      .viewMask = info.viewMask,
+      .colorAttachmentCount = static_cast<uint32_t>(color.size()),
+      .depthAttachmentCount = static_cast<uint32_t>(depth.size()),
+      .stencilAttachmentCount = static_cast<uint32_t>(stencil.size())};
+
+  record(stream::Op::BeginRendering, args,
+         std::span<const VkRenderingAttachmentInfo>(color),
+         std::span<const VkRenderingAttachmentInfo>(depth),
+         std::span<const VkRenderingAttachmentInfo>(stencil));
+  m_hasRenderPassOps = true;
+}
+
+void CommandStream::endRendering() {
+  record(stream::Op::EndRendering, uint32_t{0});
+  m_hasRenderPassOps = true;
+}
+
+void CommandStream::bindPipeline(const Pipeline &pipeline) {
+  m_bindPoint = pipeline.bindPoint();
+  m_layout = &pipeline.layout();
+  m_bindsPipeline = true;
+  track(pipeline);
+
+  record(stream::Op::BindPipeline,
+         stream::BindPipeline{.bindPoint = m_bindPoint, .pipeline = pipeline});
+}
+
+void CommandStream::setViewport(const VkViewport &viewport) {
+  record(stream::Op::SetViewport, stream::SetViewport{.viewport = viewport});
+}
+
+void CommandStream::setScissor(const VkRect2D &scissor) {
+  record(stream::Op::SetScissor, stream::SetScissor{.scissor = scissor});
+}
+
+void CommandStream::bindVertexBuffer(uint32_t binding, VertexBuffer &buffer,
+                                     VkDeviceSize offset) {
+  VkBuffer handle = *buffer;
+  track(buffer);
+
+  record(stream::Op::BindVertexBuffers,
+         stream::BindVertexBuffers{.firstBinding = binding, .bindingCount = 1},
+         std::span<const VkBuffer>(&handle, 1),
+         std::span<const VkDeviceSize>(&offset, 1));
+}
+
+void CommandStream::bindVertexBuffers(uint32_t binding,
+                                      const std::span<VertexBuffer> &buffers,
+                                      const std::span<VkDeviceSize> &offsets) {
+  if (buffers.size() != offsets.size()) {
+    Logger::error("Vertex buffer count ({}) does not match offset count ({})",
+                  buffers.size(), offsets.size());
+    return;
+  }
+
+  std::vector<VkBuffer> bufferHandles(buffers.size());
+  for (size_t i = 0; i < buffers.size(); i++) {
+    bufferHandles[i] = *buffers[i];
+    track(buffers[i]);
+  }
+
+  record(stream::Op::BindVertexBuffers,
+         stream::BindVertexBuffers{
+             .firstBinding = binding,
+             .bindingCount = static_cast<uint32_t>(buffers.size())},
+         std::span<const VkBuffer>(bufferHandles),
+         std::span<const VkDeviceSize>(offsets));
+}
+
+void CommandStream::bindIndexBuffer(IndexBuffer &buffer, VkDeviceSize offset) {
+  track(buffer);
+  record(stream::Op::BindIndexBuffer,
+         stream::BindIndexBuffer{.buffer = *buffer,
+                                 .offset = offset,
+                                 .indexType = buffer.indexType()});
+}
+
+void CommandStream::bindDescriptorSet(
+    const DescriptorSet &set, const std::span<uint32_t> dynamicOffsets) {
+  if (m_layout == nullptr) {
+    Logger::error(
+        "No pipeline bound in command stream, cannot bind descriptor set.");
+    return;
+  }
+
+  VkDescriptorSet rawSet = set;
+  track(set);
+
+  record(stream::Op::BindDescriptorSets,
+         stream::BindDescriptorSets{
+             .bindPoint = m_bindPoint,
+             .layout = *m_layout,
+             .firstSet = 0,
+             .setCount = 1,
+             .dynamicOffsetCount =
+                 static_cast<uint32_t>(dynamicOffsets.size())},
+         std::span<const VkDescriptorSet>(&rawSet, 1),
+         std::span<const uint32_t>(dynamicOffsets));
+}
+
+void CommandStream::bindDescriptorSets(
+    const std::span<DescriptorSet> &sets, uint32_t firstSet,
+    const std::span<uint32_t> dynamicOffsets) {
+  if (m_layout == nullptr) {
+    Logger::error(
+        "No pipeline bound in command stream, cannot bind descriptor sets.");
+    return;
+  }
+
+  std::vector<VkDescriptorSet> rawSets(sets.size());
+  for (size_t i = 0; i < sets.size(); i++) {
+    rawSets[i] = *sets[i];
+    track(sets[i]);
+  }
+
+  record(stream::Op::BindDescriptorSets,
+         stream::BindDescriptorSets{
+             .bindPoint = m_bindPoint,
+             .layout = *m_layout,
+             .firstSet = firstSet,
+             .setCount = static_cast<uint32_t>(rawSets.size()),
+             .dynamicOffsetCount =
+                 static_cast<uint32_t>(dynamicOffsets.size())},
+         std::span<const VkDescriptorSet>(rawSets),
+         std::span<const uint32_t>(dynamicOffsets));
+}
+
+void CommandStream::draw(uint32_t vertexCount, uint32_t instanceCount,
+                         uint32_t firstVertex, uint32_t firstInstance) {
+  record(stream::Op::Draw, stream::Draw{.vertexCount = vertexCount,
+                                        .instanceCount = instanceCount,
+                                        .firstVertex = firstVertex,
+                                        .firstInstance = firstInstance});
+}
+
+void CommandStream::drawIndexed(uint32_t indexCount, uint32_t instanceCount,
+                                uint32_t firstIndex, int32_t vertexOffset,
+                                uint32_t firstInstance) {
+  record(stream::Op::DrawIndexed,
+         stream::DrawIndexed{.indexCount = indexCount,
+                             .instanceCount = instanceCount,
+                             .firstIndex = firstIndex,
+                             .vertexOffset = vertexOffset,
+                             .firstInstance = firstInstance});
+}
+
+void CommandStream::drawIndirect(IndirectBuffer &buffer, uint32_t drawCount,
+                                 VkDeviceSize offset) {
+  if (drawCount == 0 ||
+      !buffer.canDraw(IndirectCommandType::Draw, drawCount, offset))
+    return;
+
+  track(buffer);
+  record(stream::Op::DrawIndirect,
+         stream::DrawIndirect{.buffer = *buffer,
+                              .offset = offset,
+                              .drawCount = drawCount,
+                              .stride = buffer.stride()});
+}
+
+void CommandStream::drawIndexedIndirect(IndirectBuffer &buffer,
+                                        uint32_t drawCount,
+                                        VkDeviceSize offset) {
+  if (drawCount == 0 ||
+      !buffer.canDraw(IndirectCommandType::DrawIndexed, drawCount, offset))
+    return;
+
+  track(buffer);
+  record(stream::Op::DrawIndexedIndirect,
+         stream::DrawIndirect{.buffer = *buffer,
+                              .offset = offset,
+                              .drawCount = drawCount,
+                              .stride = buffer.stride()});
+}
+
+void CommandStream::drawIndirectCount(IndirectBuffer &buffer,
+                                      Buffer &countBuffer,
+                                      uint32_t maxDrawCount,
+                                      VkDeviceSize offset,
+                                      VkDeviceSize countOffset) {
+  if (maxDrawCount == 0 ||
+      !buffer.canDrawCount(IndirectCommandType::Draw, maxDrawCount, offset,
+                           countBuffer, countOffset))
+    return;
+
+  track(buffer);
+  track(countBuffer);
+  record(stream::Op::DrawIndirectCount,
+         stream::DrawIndirectCount{.buffer = *buffer,
+                                   .offset = offset,
+                                   .countBuffer = *countBuffer,
+                                   .countOffset = countOffset,
+                                   .maxDrawCount = maxDrawCount,
+                                   .stride = buffer.stride()});
+}
+
+void CommandStream::drawIndexedIndirectCount(IndirectBuffer &buffer,
+                                             Buffer &countBuffer,
+                                             uint32_t maxDrawCount,
+                                             VkDeviceSize offset,
+                                             VkDeviceSize countOffset) {
+  if (maxDrawCount == 0 ||
+      !buffer.canDrawCount(IndirectCommandType::DrawIndexed, maxDrawCount,
+                           offset, countBuffer, countOffset))
+    return;
+
+  track(buffer);
+  track(countBuffer);
+  record(stream::Op::DrawIndexedIndirectCount,
+         stream::DrawIndirectCount{.buffer = *buffer,
+                                   .offset = offset,
+                                   .countBuffer = *countBuffer,
+                                   .countOffset = countOffset,
+                                   .maxDrawCount = maxDrawCount,
+                                   .stride = buffer.stride()});
+}
+
+void CommandStream::dispatch(uint32_t groupCountX, uint32_t groupCountY,
+                             uint32_t groupCountZ) {
+  if (groupCountX == 0 || groupCountY == 0 || groupCountZ == 0)
+    return;
+
+  record(stream::Op::Dispatch, stream::Dispatch{.groupCountX = groupCountX,
+                                                .groupCountY = groupCountY,
+                                                .groupCountZ = groupCountZ});
+  m_hasDispatches = true;
+}
+
+void CommandStream::dispatchIndirect(IndirectBuffer &buffer,
+                                     VkDeviceSize offset) {
+  if (!buffer.canRead(IndirectCommandType::Dispatch, 1, offset))
+    return;
+
+  track(buffer);
+  record(stream::Op::DispatchIndirect,
+         stream::DispatchIndirect{.buffer = *buffer, .offset = offset});
+  m_hasDispatches = true;
+}
+
+void CommandStream::copyBuffer(Buffer &src, Buffer &dst,
+                               const VkBufferCopy &region) {
+  track(src);
+  track(dst);
+  record(stream::Op::CopyBuffer,
+         stream::CopyBuffer{.src = *src, .dst = *dst, .regionCount = 1},
+         std::span<const VkBufferCopy>(&region, 1));
+}
+
+void CommandStream::copyBuffer(Buffer &src, Buffer &dst,
+                               const std::span<BufferCopy> &regions) {
+  track(src);
+  track(dst);
+  std::vector<VkBufferCopy> rawRegions(regions.begin(), regions.end());
+
+  record(stream::Op::CopyBuffer,
+         stream::CopyBuffer{.src = *src,
+                            .dst = *dst,
+                            .regionCount =
+                                static_cast<uint32_t>(rawRegions.size())},
+         std::span<const VkBufferCopy>(rawRegions));
+}
+
+void CommandStream::pipelineBarrier(
+    VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
+    std::span<const VkMemoryBarrier> memoryBarriers,
+    std::span<const VkBufferMemoryBarrier> bufferBarriers,
+    std::span<const VkImageMemoryBarrier> imageBarriers,
+    VkDependencyFlags dependencyFlags) {
+  record(stream::Op::PipelineBarrier,
+         stream::PipelineBarrier{
+             .srcStageMask = srcStageMask,
+             .dstStageMask = dstStageMask,
+             .dependencyFlags = dependencyFlags,
+             .memoryBarrierCount = static_cast<uint32_t>(memoryBarriers.size()),
+             .bufferBarrierCount = static_cast<uint32_t>(bufferBarriers.size()),
+             .imageBarrierCount = static_cast<uint32_t>(imageBarriers.size())},
+         memoryBarriers, bufferBarriers, imageBarriers);
+}
+
+void CommandStream::pushConstants(ShaderStageFlags stages, uint32_t offset,
+                                  uint32_t size, const void *data) {
+  if (m_layout == nullptr) {
+    Logger::error(
+        "No pipeline bound in command stream, cannot push constants.");
+    return;
+  }
+
+  if (!m_layout->canPushConstants(stages, offset, size))
+    return;
+
+  record(stream::Op::PushConstants,
+         stream::PushConstants{.layout = *m_layout,
+                               .stages = stages,
+                               .offset = offset,
+                               .size = size},
+         std::span<const std::byte>(static_cast<const std::byte *>(data),
+                                    size));
+}
+
+void CommandStream::replay(VkCommandBuffer cmd) const {
+  using stream::Op;
+
+  for (const auto command : *this) {
+    switch (command.op()) {
+    case Op::BeginRenderPass: {
+      const auto &args = command.args<stream::BeginRenderPass>();
+      VkRenderPassBeginInfo info{
+          .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+          .pNext = nullptr,
+          .renderPass = args.renderPass,
+          .framebuffer = args.framebuffer,
+          .renderArea = args.renderArea,
+          .clearValueCount = args.clearValueCount,
+          .pClearValues =
+              command.trailing<stream::BeginRenderPass, VkClearValue>()};
+      vkCmdBeginRenderPass(cmd, &info, args.contents);
+      break;
+    }
+    case Op::EndRenderPass: {
+      vkCmdEndRenderPass(cmd);
+      break;
+    }
+    case Op::BeginRendering: {
+      const auto &args = command.args<stream::BeginRendering>();
+      constexpr auto attachmentSize = sizeof(VkRenderingAttachmentInfo);
+
+      size_t offset = 0;
+      const auto *color =
+          command.trailing<stream::BeginRendering, VkRenderingAttachmentInfo>(
+              offset);
+      offset += alignUp(attachmentSize * args.colorAttachmentCount);
+      const auto *depth =
+          command.trailing<stream::BeginRendering, VkRenderingAttachmentInfo>(
+              offset);
+      offset += alignUp(attachmentSize * args.depthAttachmentCount);
+      const auto *stencil =
+          command.trailing<stream::BeginRendering, VkRenderingAttachmentInfo>(
+              offset);
+
+      VkRenderingInfo info{
+          .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+          .pNext = nullptr,
+          .flags = args.flags,
+          .renderArea = args.renderArea,
+          .layerCount = args.layerCount,
+          .viewMask = args.viewMask,
+          .colorAttachmentCount = args.colorAttachmentCount,
+          .pColorAttachments = color,
+          .pDepthAttachment = args.depthAttachmentCount > 0 ? depth : nullptr,
+          .pStencilAttachment =
+              args.stencilAttachmentCount > 0 ? stencil : nullptr};
+      vkCmdBeginRendering(cmd, &info);
+      break;
+    }
+    case Op::EndRendering: {
+      vkCmdEndRendering(cmd);
+      break;
+    }
+    case Op::BindPipeline: {
+      const auto &args = command.args<stream::BindPipeline>();
+      vkCmdBindPipeline(cmd, args.bindPoint, args.pipeline);
+      break;
+    }
+    case Op::SetViewport: {
+      vkCmdSetViewport(cmd, 0, 1,
+                       &command.args<stream::SetViewport>().viewport);
+      break;
+    }
+    case Op::SetScissor: {
+      vkCmdSetScissor(cmd, 0, 1, &command.args<stream::SetScissor>().scissor);
+      break;
+    }
+    case Op::BindVertexBuffers: {
+      const auto &args = command.args<stream::BindVertexBuffers>();
+      const auto *buffers =
+          command.trailing<stream::BindVertexBuffers, VkBuffer>();
+      const auto *offsets =
+          command.trailing<stream::BindVertexBuffers, VkDeviceSize>(
+              alignUp(sizeof(VkBuffer) * args.bindingCount));
+      vkCmdBindVertexBuffers(cmd, args.firstBinding, args.bindingCount,
+                             buffers, offsets);
+      break;
+    }
+    case Op::BindIndexBuffer: {
+      const auto &args = command.args<stream::BindIndexBuffer>();
+      vkCmdBindIndexBuffer(cmd, args.buffer, args.offset, args.indexType);
+      break;
+    }
+    case Op::BindDescriptorSets: {
+      const auto &args = command.args<stream::BindDescriptorSets>();
+      const auto *sets =
+          command.trailing<stream::BindDescriptorSets, VkDescriptorSet>();
+      const auto *dynamicOffsets =
+          command.trailing<stream::BindDescriptorSets, uint32_t>(
+              alignUp(sizeof(VkDescriptorSet) * args.setCount));
+      vkCmdBindDescriptorSets(cmd, args.bindPoint, args.layout, args.firstSet,
+                              args.setCount, sets, args.dynamicOffsetCount,
+                              dynamicOffsets);
+      break;
+    }
+    case Op::Draw: {
+      const auto &args = command.args<stream::Draw>();
+      vkCmdDraw(cmd, args.vertexCount, args.instanceCount, args.firstVertex,
+                args.firstInstance);
+      break;
+    }
+    case Op::DrawIndexed: {
+      const auto &args = command.args<stream::DrawIndexed>();
+      vkCmdDrawIndexed(cmd, args.indexCount, args.instanceCount,
+                       args.firstIndex, args.vertexOffset, args.firstInstance);
+      break;
+    }
+    case Op::DrawIndirect: {
+      const auto &args = command.args<stream::DrawIndirect>();
+      vkCmdDrawIndirect(cmd, args.buffer, args.offset, args.drawCount,
+                        args.stride);
+      break;
+    }
+    case Op::DrawIndexedIndirect: {
+      const auto &args = command.args<stream::DrawIndirect>();
+      vkCmdDrawIndexedIndirect(cmd, args.buffer, args.offset, args.drawCount,
+                               args.stride);
+      break;
+    }
+    case Op::DrawIndirectCount: {
+      const auto &args = command.args<stream::DrawIndirectCount>();
+      vkCmdDrawIndirectCount(cmd, args.buffer, args.offset, args.countBuffer,
+                             args.countOffset, args.maxDrawCount, args.stride);
+      break;
+    }
+    case Op::DrawIndexedIndirectCount: {
+      const auto &args = command.args<stream::DrawIndirectCount>();
+      vkCmdDrawIndexedIndirectCount(cmd, args.buffer, args.offset,
+                                    args.countBuffer, args.countOffset,
+                                    args.maxDrawCount, args.stride);
+      break;
+    }
+    case Op::Dispatch: {
+      const auto &args = command.args<stream::Dispatch>();
+      vkCmdDispatch(cmd, args.groupCountX, args.groupCountY, args.groupCountZ);
+      break;
+    }
+    case Op::DispatchIndirect: {
+      const auto &args = command.args<stream::DispatchIndirect>();
+      vkCmdDispatchIndirect(cmd, args.buffer, args.offset);
+      break;
+    }
+    case Op::CopyBuffer: {
+      const auto &args = command.args<stream::CopyBuffer>();
+      vkCmdCopyBuffer(cmd, args.src, args.dst, args.regionCount,
+                      command.trailing<stream::CopyBuffer, VkBufferCopy>());
+      break;
+    }
+    case Op::PipelineBarrier: {
+      const auto &args = command.args<stream::PipelineBarrier>();
+      size_t offset = 0;
+      const auto *memoryBarriers =
+          command.trailing<stream::PipelineBarrier, VkMemoryBarrier>(offset);
+      offset += alignUp(sizeof(VkMemoryBarrier) * args.memoryBarrierCount);
+      const auto *bufferBarriers =
+          command.trailing<stream::PipelineBarrier, VkBufferMemoryBarrier>(
+              offset);
+      offset +=
+          alignUp(sizeof(VkBufferMemoryBarrier) * args.bufferBarrierCount);
+      const auto *imageBarriers =
+          command.trailing<stream::PipelineBarrier, VkImageMemoryBarrier>(
+              offset);
+      vkCmdPipelineBarrier(cmd, args.srcStageMask, args.dstStageMask,
+                           args.dependencyFlags, args.memoryBarrierCount,
+                           memoryBarriers, args.bufferBarrierCount,
+                           bufferBarriers, args.imageBarrierCount,
+                           imageBarriers);
+      break;
+    }
+    case Op::PushConstants: {
+      const auto &args = command.args<stream::PushConstants>();
+      vkCmdPushConstants(cmd, args.layout, args.stages, args.offset, args.size,
+                         command.trailing<stream::PushConstants, std::byte>());
+      break;
+    }
+    }
+  }
+}
+} // namespace vk
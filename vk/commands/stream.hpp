@@ -0,0 +1,427 @@
+#pragma once
+
+#include "buffers.hpp"
+#include "enums/shader-stage.hpp"
+#include "pipeline/layout.hpp"
+#include "versioned.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace vk {
+class Pipeline;
+class PipelineLayout;
+class DescriptorSet;
+class Buffer;
+class VertexBuffer;
+class IndexBuffer;
+class IndirectBuffer;
+
+// Fixed size argument blocks for each recorded command. Variable length data
+// (buffers, offsets, clear values, barriers...) follows the block directly in
+// the stream, with the block holding the element counts.
+namespace stream {
+enum class Op : uint8_t {
+  BeginRenderPass,
+  EndRenderPass,
+  BeginRendering,
+  EndRendering,
+  BindPipeline,
+  SetViewport,
+  SetScissor,
+  BindVertexBuffers,
+  BindIndexBuffer,
+  BindDescriptorSets,
+  Draw,
+  DrawIndexed,
+  DrawIndirect,
+  DrawIndexedIndirect,
+  DrawIndirectCount,
+  DrawIndexedIndirectCount,
+  Dispatch,
+  DispatchIndirect,
+  CopyBuffer,
+  PipelineBarrier,
+  PushConstants,
+};
+
+struct BeginRenderPass {
+  VkRenderPass renderPass;
+  VkFramebuffer framebuffer;
+  VkRect2D renderArea;
+  VkSubpassContents contents;
+  uint32_t clearValueCount;
+  // VkClearValue[clearValueCount]
+};
+
+struct BeginRendering {
+  VkRenderingFlags flags;
+  VkRect2D renderArea;
+  uint32_t layerCount;
+  uint32_t viewMask;
+  uint32_t colorAttachmentCount;
+  uint32_t depthAttachmentCount;
+  uint32_t stencilAttachmentCount;
+  // VkRenderingAttachmentInfo[colorAttachmentCount],
+  // VkRenderingAttachmentInfo[depthAttachmentCount],
+  // VkRenderingAttachmentInfo[stencilAttachmentCount]
+};
+
+struct BindPipeline {
+  VkPipelineBindPoint bindPoint;
+  VkPipeline pipeline;
+};
+
+struct SetViewport {
+  VkViewport viewport;
+};
+
+struct SetScissor {
+  VkRect2D scissor;
+};
+
+struct BindVertexBuffers {
+  uint32_t firstBinding;
+  uint32_t bindingCount;
+  // VkBuffer[bindingCount], VkDeviceSize[bindingCount]
+};
+
+struct BindIndexBuffer {
+  VkBuffer buffer;
+  VkDeviceSize offset;
+  VkIndexType indexType;
+};
+
+struct BindDescriptorSets {
+  VkPipelineBindPoint bindPoint;
+  VkPipelineLayout layout;
+  uint32_t firstSet;
+  uint32_t setCount;
+  uint32_t dynamicOffsetCount;
+  // VkDescriptorSet[setCount], uint32_t[dynamicOffsetCount]
+};
+
+struct Draw {
+  uint32_t vertexCount;
+  uint32_t instanceCount;
+  uint32_t firstVertex;
+  uint32_t firstInstance;
+};
+
+struct DrawIndexed {
+  uint32_t indexCount;
+  uint32_t instanceCount;
+  uint32_t firstIndex;
+  int32_t vertexOffset;
+  uint32_t firstInstance;
+};
+
+// Shared by the plain and indexed variants
+struct DrawIndirect {
+  VkBuffer buffer;
+  VkDeviceSize offset;
+  uint32_t drawCount;
+  uint32_t stride;
+};
+
+struct DrawIndirectCount {
+  VkBuffer buffer;
+  VkDeviceSize offset;
+  VkBuffer countBuffer;
+  VkDeviceSize countOffset;
+  uint32_t maxDrawCount;
+  uint32_t stride;
+};
+
+struct Dispatch {
+  uint32_t groupCountX;
+  uint32_t groupCountY;
+  uint32_t groupCountZ;
+};
+
+struct DispatchIndirect {
+  VkBuffer buffer;
+  VkDeviceSize offset;
+};
+
+struct CopyBuffer {
+  VkBuffer src;
+  VkBuffer dst;
+  uint32_t regionCount;
+  // VkBufferCopy[regionCount]
+};
+
+struct PipelineBarrier {
+  VkPipelineStageFlags srcStageMask;
+  VkPipelineStageFlags dstStageMask;
+  VkDependencyFlags dependencyFlags;
+  uint32_t memoryBarrierCount;
+  uint32_t bufferBarrierCount;
+  uint32_t imageBarrierCount;
+  // VkMemoryBarrier[memoryBarrierCount],
+  // VkBufferMemoryBarrier[bufferBarrierCount],
+  // VkImageMemoryBarrier[imageBarrierCount]
+};
+struct PushConstants {
+  VkPipelineLayout layout;
+  VkShaderStageFlags stages;
+  uint32_t offset;
+  uint32_t size;
+  // std::byte[size]
+};
+} // namespace stream
+
+// A packed, GPU-free recording of command buffer work.
+//
+// The recording API mirrors `CommandBuffer::Encoder` and
+// `CommandBuffer::Encoder::RenderPass`, so streams can be built on any thread
+// and translated into a real command buffer later with `replay`.
+class CommandStream {
+public:
+  // Every header, argument block and trailing array starts on this boundary so
+  // recorded data can be handed to Vulkan without copying it out first.
+  static constexpr size_t Alignment = 8;
+
+  struct Header {
+    stream::Op op;
+    uint32_t size;
+  };
+
+  class Command {
+    const std::byte *m_data;
+    Header m_header;
+
+  public:
+    Command(const std::byte *data, Header header)
+        : m_data(data), m_header(header) {}
+
+    [[nodiscard]] auto op() const -> stream::Op { return m_header.op; }
+    [[nodiscard]] auto size() const -> uint32_t { return m_header.size; }
+
+    template <typename T> [[nodiscard]] auto args() const -> const T & {
+      return *reinterpret_cast<const T *>(m_data);
+    }
+
+    // Trailing array data, `byteOffset` bytes after the end of the argument
+    // block `T`.
+    template <typename T, typename Elem>
+    [[nodiscard]] auto trailing(size_t byteOffset = 0) const -> const Elem * {
+      return reinterpret_cast<const Elem *>(m_data + alignUp(sizeof(T)) +
+                                            byteOffset);
+    }
+  };
+
+  class Iterator {
+    const std::byte *m_ptr;
+
+  public:
+    explicit Iterator(const std::byte *ptr) : m_ptr(ptr) {}
+
+    auto operator*() const -> Command {
+      Header header;
+      std::memcpy(&header, m_ptr, sizeof(Header));
+      return {m_ptr + alignUp(sizeof(Header)), header};
+    }
+
+    auto operator++() -> Iterator & {
+      Header header;
+      std::memcpy(&header, m_ptr, sizeof(Header));
+      m_ptr += alignUp(sizeof(Header)) + header.size;
+      return *this;
+    }
+
+    auto operator==(const Iterator &o) const -> bool = default;
+  };
+
+private:
+  std::vector<std::byte> m_bytes;
+  uint32_t m_commandCount = 0;
+  bool m_hasRenderPassOps = false;
+  bool m_hasDispatches = false;
+  bool m_bindsPipeline = false;
+
+  // Layout of the last pipeline bound in this stream, used to resolve
+  // descriptor set binds the same way the encoder does.
+  VkPipelineBindPoint m_bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  const PipelineLayout *m_layout = nullptr;
+
+  // Snapshots of every pipeline, buffer and descriptor set referenced, only
+  // taken when tracking is enabled
+  bool m_trackDependencies = false;
+  std::vector<VersionSnapshot> m_dependencies;
+
+  auto track(const Versioned &object) -> void {
+    if (m_trackDependencies) {
+      m_dependencies.emplace_back(object);
+    }
+  }
+
+  static constexpr auto alignUp(size_t size) -> size_t {
+    return (size + Alignment - 1) & ~(Alignment - 1);
+  }
+
+  auto write(const void *data, size_t size) -> void {
+    auto offset = m_bytes.size();
+    m_bytes.resize(offset + alignUp(size));
+    if (size > 0) {
+      std::memcpy(m_bytes.data() + offset, data, size);
+    }
+  }
+
+  template <typename T, typename... Elems>
+  auto record(stream::Op op, const T &args, std::span<const Elems>... arrays)
+      -> void {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert((std::is_trivially_copyable_v<Elems> && ...));
+
+    size_t size = alignUp(sizeof(T)) + (alignUp(arrays.size_bytes()) + ... + 0);
+    Header header{.op = op, .size = static_cast<uint32_t>(size)};
+
+    m_bytes.reserve(m_bytes.size() + alignUp(sizeof(Header)) + size);
+    write(&header, sizeof(Header));
+    write(&args, sizeof(T));
+    (write(arrays.data(), arrays.size_bytes()), ...);
+
+    m_commandCount++;
+  }
+
+public:
+  CommandStream() = default;
+  CommandStream(const CommandStream &) = default;
+  auto operator=(const CommandStream &) -> CommandStream & = default;
+  CommandStream(CommandStream &&) noexcept = default;
+  auto operator=(CommandStream &&) noexcept -> CommandStream & = default;
+
+  [[nodiscard]] auto begin() const -> Iterator {
+    return Iterator(m_bytes.data());
+  }
+  [[nodiscard]] auto end() const -> Iterator {
+    return Iterator(m_bytes.data() + m_bytes.size());
+  }
+
+  [[nodiscard]] auto empty() const -> bool { return m_commandCount == 0; }
+  [[nodiscard]] auto commandCount() const -> uint32_t { return m_commandCount; }
+  [[nodiscard]] auto byteSize() const -> size_t { return m_bytes.size(); }
+  [[nodiscard]] auto bytes() const -> std::span<const std::byte> {
+    return m_bytes;
+  }
+
+  // True if the stream begins or ends render passes itself, in which case it
+  // must be replayed outside of a render pass.
+  [[nodiscard]] auto hasRenderPassOps() const -> bool {
+    return m_hasRenderPassOps;
+  }
+
+  // True if the stream dispatches compute work, in which case it must also be
+  // replayed outside of a render pass.
+  [[nodiscard]] auto hasDispatches() const -> bool { return m_hasDispatches; }
+
+  // True if the stream binds a pipeline, replacing the one the encoder bound
+  [[nodiscard]] auto bindsPipeline() const -> bool { return m_bindsPipeline; }
+
+  auto clear() -> void;
+
+  // Remember the objects referenced by commands recorded from now on, so
+  // `isCurrent` can tell when the recording has gone stale.
+  auto trackDependencies(bool enable = true) -> void {
+    m_trackDependencies = enable;
+  }
+
+  // False once a tracked object was destroyed or changed since recording
+  [[nodiscard]] auto isCurrent() const -> bool;
+  auto reserve(size_t bytes) -> void { m_bytes.reserve(bytes); }
+
+  // Append the commands of another stream, e.g. to merge per-thread streams
+  // before replaying them.
+  auto append(const CommandStream &other) -> CommandStream &;
+
+  void beginRenderPass(const VkRenderPassBeginInfo &info,
+                       const VkSubpassContents contents =
+                           VK_SUBPASS_CONTENTS_INLINE);
+  void endRenderPass();
+
+  // Attachment pNext chains are dropped when recording
+  void beginRendering(const VkRenderingInfo &info);
+  void endRendering();
+
+  void bindPipeline(const Pipeline &pipeline);
+
+  void setViewport(const VkViewport &viewport);
+  void setScissor(const VkRect2D &scissor);
+
+  void bindVertexBuffer(uint32_t binding, VertexBuffer &buffer,
+                        VkDeviceSize bufferOffset = 0);
+
+  void bindVertexBuffers(uint32_t binding,
+                         const std::span<VertexBuffer> &buffers,
+                         const std::span<VkDeviceSize> &offsets);
+
+  void bindIndexBuffer(IndexBuffer &buffer, VkDeviceSize offset = 0);
+
+  void bindDescriptorSet(const DescriptorSet &set,
+                         const std::span<uint32_t> dynamicOffsets = {});
+  void bindDescriptorSets(const std::span<DescriptorSet> &sets,
+                          uint32_t firstSet = 0,
+                          const std::span<uint32_t> dynamicOffsets = {});
+
+  void draw(uint32_t vertexCount, uint32_t instanceCount = 1,
+            uint32_t firstVertex = 0, uint32_t firstInstance = 0);
+
+  void drawIndexed(uint32_t indexCount, uint32_t instanceCount = 1,
+                   uint32_t firstIndex = 0, int32_t vertexOffset = 0,
+                   uint32_t firstInstance = 0);
+
+  void drawIndirect(IndirectBuffer &buffer, uint32_t drawCount,
+                    VkDeviceSize offset = 0);
+  void drawIndexedIndirect(IndirectBuffer &buffer, uint32_t drawCount,
+                           VkDeviceSize offset = 0);
+
+  void drawIndirectCount(IndirectBuffer &buffer, Buffer &countBuffer,
+                         uint32_t maxDrawCount, VkDeviceSize offset = 0,
+                         VkDeviceSize countOffset = 0);
+  void drawIndexedIndirectCount(IndirectBuffer &buffer, Buffer &countBuffer,
+                                uint32_t maxDrawCount, VkDeviceSize offset = 0,
+                                VkDeviceSize countOffset = 0);
+
+  void dispatch(uint32_t groupCountX, uint32_t groupCountY = 1,
+                uint32_t groupCountZ = 1);
+  void dispatchIndirect(IndirectBuffer &buffer, VkDeviceSize offset = 0);
+
+  void copyBuffer(Buffer &src, Buffer &dst, const VkBufferCopy &region);
+  void copyBuffer(Buffer &src, Buffer &dst,
+                  const std::span<BufferCopy> &regions);
+
+  // Barriers are stored by value, so any pNext chains they carry must outlive
+  // the stream.
+  void pipelineBarrier(VkPipelineStageFlags srcStageMask,
+                       VkPipelineStageFlags dstStageMask,
+                       std::span<const VkMemoryBarrier> memoryBarriers = {},
+                       std::span<const VkBufferMemoryBarrier> bufferBarriers =
+                           {},
+                       std::span<const VkImageMemoryBarrier> imageBarriers = {},
+                       VkDependencyFlags dependencyFlags = 0);
+
+  void pushConstants(ShaderStageFlags stages, uint32_t offset, uint32_t size,
+                     const void *data);
+
+  template <typename T>
+  void pushConstants(ShaderStageFlags stages, uint32_t offset, const T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(sizeof(T) % 4 == 0,
+                  "Push constant blocks must be a multiple of 4 bytes");
+    static_assert(sizeof(T) <= MinPushConstantsSize,
+                  "Push constant block may exceed the device limit, use the "
+                  "untyped overload");
+    pushConstants(stages, offset, sizeof(T), &value);
+  }
+
+  // Translate the recorded commands into `commandBuffer`, which must be in
+  // the recording state.
+  void replay(VkCommandBuffer commandBuffer) const;
+};
+} // namespace vk
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "sync/timeline.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace vk {
+// Defers destroying Vulkan objects until the GPU is done with them, so
+// replacing a resource at runtime does not need `Device::waitIdle`.
+//
+// Objects are retired against a point on a monotonic counter, either a
+// timeline value (see `QueueTimeline`) or a frame number, and destroyed by
+// `collect` once the caller reports that point as completed. Any type with a
+// `release()` member can be retired, which covers every `Handle` as well as
+// `CommandBuffer::Encoder::TemporaryStaging`.
+class DeletionQueue {
+  struct Deferred {
+    virtual ~Deferred() = default;
+  };
+
+  template <typename T> struct Holder : Deferred {
+    T object;
+
+    explicit Holder(T &&object) : object(std::move(object)) {}
+    ~Holder() override { object.release(); }
+  };
+
+  struct Entry {
+    uint64_t point;
+    std::unique_ptr<Deferred> object;
+  };
+
+  // Sorted by point; retiring is almost always in order so inserts append
+  std::deque<Entry> m_entries;
+
+public:
+  DeletionQueue() = default;
+  DeletionQueue(DeletionQueue &&other) noexcept = default;
+  auto operator=(DeletionQueue &&other) noexcept -> DeletionQueue & = default;
+
+  // Whatever is still queued is destroyed immediately, so the owner has to
+  // make sure the GPU is idle by then
+  ~DeletionQueue() { flush(); }
+
+  // Take ownership of `object` and destroy it once `point` has completed
+  template <typename T>
+    requires(!std::is_lvalue_reference_v<T>) &&
+            requires(T &object) { object.release(); }
+  void retire(T &&object, uint64_t point) {
+    auto it = std::upper_bound(
+        m_entries.begin(), m_entries.end(), point,
+        [](uint64_t value, const Entry &entry) { return value < entry.point; });
+    m_entries.insert(it, Entry{.point = point,
+                               .object = std::make_unique<Holder<T>>(
+                                   std::move(object))});
+  }
+
+  // Retire against the value the timeline's next submission will signal
+  template <typename T> void retire(T &&object, const QueueTimeline &timeline) {
+    retire(std::forward<T>(object), timeline.next());
+  }
+
+  // Destroy everything retired at or before `completed`. Returns the number
+  // of objects destroyed.
+  auto collect(uint64_t completed) -> size_t {
+    size_t count = 0;
+    while (!m_entries.empty() && m_entries.front().point <= completed) {
+      m_entries.pop_front();
+      count++;
+    }
+    return count;
+  }
+
+  auto collect(const QueueTimeline &timeline) -> size_t {
+    return collect(timeline.completed());
+  }
+
+  // Destroy everything regardless of its point, e.g. after waiting idle at
+  // shutdown
+  void flush() { m_entries.clear(); }
+
+  [[nodiscard]] auto size() const -> size_t { return m_entries.size(); }
+  [[nodiscard]] auto empty() const -> bool { return m_entries.empty(); }
+};
+} // namespace vk
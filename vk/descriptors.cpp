@@ -176,7 +176,7 @@ DescriptorSetAllocate::DescriptorSetAllocate(
     VkDescriptorSetAllocateInfo &&other)
     : VkDescriptorSetAllocateInfo(other) {}
 
-DescriptorBuffer::DescriptorBuffer(Buffer buf, VkDescriptorType bufType,
+DescriptorBuffer::DescriptorBuffer(Buffer &buf, VkDescriptorType bufType,
                                    VkDeviceSize offset, VkDeviceSize range)
     : VkDescriptorBufferInfo{.buffer = buf, .offset = offset, .range = range},
       m_bufferType(bufType) {}
@@ -193,6 +193,7 @@ DescriptorSet::DescriptorSet(VkDescriptorSet set, Device &device)
 
 void DescriptorSet::update(DescriptorSetWrite &write) {
   vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+  bumpVersion();
 }
 
 DescriptorSetWrite::DescriptorSetWrite(DescriptorSet &set, uint32_t binding)
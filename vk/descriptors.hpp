@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ref.hpp"
+#include "versioned.hpp"
 
 #include <bit>
 #include <cstdint>
@@ -218,7 +219,9 @@ class DescriptorBuffer : public VkDescriptorBufferInfo {
   VkDescriptorType m_bufferType;
 
 public:
-  DescriptorBuffer(Buffer buf, VkDescriptorType bufType,
+  // By reference: buffers are move only, so taking one by value consumed
+  // the caller's buffer
+  DescriptorBuffer(Buffer &buf, VkDescriptorType bufType,
                    VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
 
   DescriptorBuffer(UniformBuffer &buf, VkDeviceSize offset = 0,
@@ -231,7 +234,9 @@ public:
 
 class DescriptorSetWrite;
 
-class DescriptorSet {
+// Updates bump the version, as they invalidate command buffers the set is
+// bound in.
+class DescriptorSet : public Versioned {
   VkDescriptorSet m_handle;
   RawRef<Device, VkDevice> m_device;
 
@@ -7,23 +7,56 @@
 #include "image-view.hpp"
 #include "image.hpp"
 #include "khr/swapchain.hpp"
+#include "pipeline/compute.hpp"
+#include "pipeline/layout.hpp"
 #include "queue.hpp"
+#include "util/vk-logger.hpp"
 
 #include <optional>
+#include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace vk {
+auto info::DeviceCreate::clampQueueCounts(const QueueFamilies &families)
+    -> DeviceCreate & {
+  for (auto &info : m_queueCreateInfos) {
+    if (info.queueFamilyIndex >= families.size()) {
+      continue;
+    }
+
+    auto available = families[info.queueFamilyIndex].getQueueCount();
+    if (info.queueCount > available) {
+      Logger::warn("Requested {} queues from family {}, which only has {}",
+                   info.queueCount, info.queueFamilyIndex, available);
+      info.truncate(available);
+    }
+  }
+
+  setupQueueCreateInfos();
+  return *this;
+}
+
 auto Device::create(PhysicalDevice &physicalDevice,
                     vk::info::DeviceCreate &createInfo) noexcept
     -> std::optional<Device> {
+  auto families = physicalDevice.getQueues();
+  auto clamped = createInfo;
+  clamped.clampQueueCounts(families);
 
   VkDevice device;
-  VkResult result =
-      vkCreateDevice(*physicalDevice, &createInfo, nullptr, &device);
+  VkResult result = vkCreateDevice(*physicalDevice, &clamped, nullptr, &device);
   if (result != VK_SUCCESS) {
     return std::nullopt;
   }
-  return Device(device, physicalDevice);
+
+  std::vector<uint32_t> queueCounts(families.size(), 0);
+  for (const auto &info : clamped.queueCreateInfos()) {
+    if (info.queueFamilyIndex < queueCounts.size()) {
+      queueCounts[info.queueFamilyIndex] = info.queueCount;
+    }
+  }
+
+  return Device(device, physicalDevice, std::move(queueCounts), clamped);
 }
 
 auto Device::getQueue(QueueFamily &family, uint32_t queueIndex)
@@ -33,6 +66,12 @@ auto Device::getQueue(QueueFamily &family, uint32_t queueIndex)
 
 auto Device::getQueue(int32_t queueFamilyIndex, uint32_t queueIndex)
     -> std::optional<Queue> {
+  if (queueIndex >= queueCount(queueFamilyIndex)) {
+    Logger::error("Queue {} of family {} was not created", queueIndex,
+                  queueFamilyIndex);
+    return std::nullopt;
+  }
+
   VkQueue queue;
   vkGetDeviceQueue(m_handle, queueFamilyIndex, queueIndex, &queue);
   if (queue == VK_NULL_HANDLE) {
@@ -41,6 +80,22 @@ auto Device::getQueue(int32_t queueFamilyIndex, uint32_t queueIndex)
   return Queue(queue, queueFamilyIndex);
 }
 
+auto Device::getQueues(QueueFamily &family) -> std::vector<Queue> {
+  return getQueues(family.getIndex());
+}
+
+auto Device::getQueues(uint32_t queueFamilyIndex) -> std::vector<Queue> {
+  std::vector<Queue> queues;
+  auto count = queueCount(queueFamilyIndex);
+  queues.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    VkQueue queue;
+    vkGetDeviceQueue(m_handle, queueFamilyIndex, i, &queue);
+    queues.emplace_back(queue, queueFamilyIndex);
+  }
+  return queues;
+}
+
 auto Device::createSwapchain(vk::info::SwapchainCreate &info)
     -> std::optional<khr::Swapchain> {
   return khr::Swapchain::create(*this, info);
@@ -55,6 +110,11 @@ auto Device::createSemaphore() -> std::optional<Semaphore> {
   return Semaphore::create(*this);
 }
 
+auto Device::createTimelineSemaphore(uint64_t initialValue)
+    -> std::optional<Semaphore> {
+  return Semaphore::createTimeline(*this, initialValue);
+}
+
 auto Device::createFence(bool signaled) -> std::optional<Fence> {
   return Fence::create(*this, signaled);
 }
@@ -80,6 +140,11 @@ auto Device::createUniformBuffer(vk::info::UniformBufferCreate &info)
   return UniformBuffer::create(*this, info);
 }
 
+auto Device::createIndirectBuffer(vk::info::IndirectBufferCreate &info)
+    -> std::optional<IndirectBuffer> {
+  return IndirectBuffer::create(*this, info);
+}
+
 auto Device::allocateMemory(Buffer &buffer, MemoryProperties properties)
     -> std::optional<DeviceMemory> {
   auto memoryReqs = buffer.getMemoryRequirements();
@@ -137,4 +202,14 @@ auto Device::createDescriptorPool(info::DescriptorPoolCreate &info)
     -> std::optional<vk::DescriptorPool> {
   return vk::DescriptorPool::create(*this, info);
 }
+
+auto Device::createPipelineLayout(info::PipelineLayoutCreate &info)
+    -> std::optional<PipelineLayout> {
+  return PipelineLayout::create(*this, info);
+}
+
+auto Device::createComputePipeline(info::ComputePipelineCreate &info)
+    -> std::optional<ComputePipeline> {
+  return ComputePipeline::create(*this, info);
+}
 } // namespace vk
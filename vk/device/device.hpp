@@ -6,7 +6,11 @@
 #include "queue.hpp"
 #include "ref.hpp"
 #include <optional>
+#include <algorithm>
 #include <span>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace vk {
@@ -22,13 +26,19 @@ class DeviceMemory;
 class VertexBuffer;
 class IndexBuffer;
 class UniformBuffer;
+class IndirectBuffer;
 
 class DescriptorSetLayout;
 class DescriptorPool;
 
+class PipelineLayout;
+class ComputePipeline;
+
 namespace info {
 class DescriptorSetLayoutCreate;
 class DescriptorPoolCreate;
+class PipelineLayoutCreate;
+class ComputePipelineCreate;
 class SwapchainCreate;
 class CommandPoolCreate;
 } // namespace info
@@ -76,6 +86,29 @@ public:
     return *this;
   }
 
+  // Request the queues of another create info for the same family as well
+  auto merge(const DeviceQueueCreate &other) -> DeviceQueueCreate & {
+    m_priorities.insert(m_priorities.end(), other.m_priorities.begin(),
+                        other.m_priorities.end());
+    setupPriorities();
+
+    return *this;
+  }
+
+  // Drop queues past `count`, keeping the earliest requested priorities
+  auto truncate(uint32_t count) -> DeviceQueueCreate & {
+    if (count < m_priorities.size()) {
+      m_priorities.resize(count);
+      setupPriorities();
+    }
+
+    return *this;
+  }
+
+  [[nodiscard]] auto priorities() const -> const std::vector<float> & {
+    return m_priorities;
+  }
+
   DeviceQueueCreate(const DeviceQueueCreate &other)
       : VkDeviceQueueCreateInfo{other}, m_priorities(other.m_priorities) {
     setupPriorities();
@@ -91,12 +124,55 @@ public:
 
 class DeviceCreate : public VkDeviceCreateInfo {
   PhysicalDeviceFeatures m_features{};
+  std::optional<VkPhysicalDeviceVulkan12Features> m_vulkan12Features;
+  std::optional<VkPhysicalDeviceVulkan13Features> m_vulkan13Features;
+  std::optional<VkPhysicalDevicePresentIdFeaturesKHR> m_presentIdFeatures;
+  std::optional<VkPhysicalDevicePresentWaitFeaturesKHR> m_presentWaitFeatures;
   std::vector<vk::info::DeviceQueueCreate> m_queueCreateInfos{};
+  // Contiguous copies for Vulkan, the builders are larger than the structs
+  std::vector<VkDeviceQueueCreateInfo> m_vkQueueCreateInfos{};
   std::vector<char const *> m_extensions{};
 
-  void setupQueues() {
-    queueCreateInfoCount = static_cast<uint32_t>(m_queueCreateInfos.size());
-    pQueueCreateInfos = m_queueCreateInfos.data();
+  void setupFeatureChain() {
+    void *next = nullptr;
+
+    if (m_vulkan12Features.has_value()) {
+      m_vulkan12Features->sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+      m_vulkan12Features->pNext = next;
+      next = &m_vulkan12Features.value();
+    }
+
+    if (m_vulkan13Features.has_value()) {
+      m_vulkan13Features->sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+      m_vulkan13Features->pNext = next;
+      next = &m_vulkan13Features.value();
+    }
+
+    if (m_presentIdFeatures.has_value()) {
+      m_presentIdFeatures->sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+      m_presentIdFeatures->pNext = next;
+      next = &m_presentIdFeatures.value();
+    }
+
+    if (m_presentWaitFeatures.has_value()) {
+      m_presentWaitFeatures->sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+      m_presentWaitFeatures->pNext = next;
+      next = &m_presentWaitFeatures.value();
+    }
+
+    pNext = next;
+  }
+
+  void setupQueueCreateInfos() {
+    m_vkQueueCreateInfos.assign(m_queueCreateInfos.begin(),
+                                m_queueCreateInfos.end());
+    queueCreateInfoCount = static_cast<uint32_t>(m_vkQueueCreateInfos.size());
+    pQueueCreateInfos =
+        m_vkQueueCreateInfos.empty() ? nullptr : m_vkQueueCreateInfos.data();
   }
 
   void setupExtensions() {
@@ -130,6 +206,26 @@ public:
     return *this;
   }
 
+  // Requires a device supporting Vulkan 1.2 and an instance created with at
+  // least that API version.
+  auto enableVulkan12Features(const VkPhysicalDeviceVulkan12Features &features)
+      -> DeviceCreate & {
+    m_vulkan12Features = features;
+    setupFeatureChain();
+
+    return *this;
+  }
+
+  // Requires a device supporting Vulkan 1.3 and an instance created with at
+  // least that API version.
+  auto enableVulkan13Features(const VkPhysicalDeviceVulkan13Features &features)
+      -> DeviceCreate & {
+    m_vulkan13Features = features;
+    setupFeatureChain();
+
+    return *this;
+  }
+
   template <typename... Args>
     requires requires {
       !std::same_as<typename std::tuple_element_t<0, std::tuple<Args...>>::type,
@@ -144,21 +240,79 @@ public:
     return addQueue(queueCreateInfo);
   }
 
+  // Vulkan allows one create info per family, so requests for a family that
+  // already has one add their queues to it
   auto addQueue(const DeviceQueueCreate &queueCreateInfo) -> DeviceCreate & {
     auto queueIdx = queueCreateInfo.queueFamilyIndex;
 
     for (auto &info : m_queueCreateInfos) {
       if (info.queueFamilyIndex == queueIdx) {
+        info.merge(queueCreateInfo);
+        setupQueueCreateInfos();
         return *this;
       }
     }
 
     m_queueCreateInfos.push_back(queueCreateInfo);
 
-    setupQueues();
+    setupQueueCreateInfos();
     return *this;
   }
 
+  // Clamp every family's queue count to what the device exposes.
+  // `Device::create` does this on a copy, leaving the caller's info as is.
+  auto clampQueueCounts(const QueueFamilies &families) -> DeviceCreate &;
+
+  [[nodiscard]] auto queueCreateInfos() const
+      -> const std::vector<DeviceQueueCreate> & {
+    return m_queueCreateInfos;
+  }
+
+  // Enable VK_KHR_present_id and VK_KHR_present_wait with their features,
+  // for `khr::Swapchain::waitForPresent`
+  auto enablePresentWait() -> DeviceCreate & {
+    m_presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext = nullptr,
+        .presentId = VK_TRUE};
+    m_presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .pNext = nullptr,
+        .presentWait = VK_TRUE};
+    setupFeatureChain();
+
+    return enableExtensions({VK_KHR_PRESENT_ID_EXTENSION_NAME,
+                             VK_KHR_PRESENT_WAIT_EXTENSION_NAME});
+  }
+
+  [[nodiscard]] auto extensions() const -> const std::vector<char const *> & {
+    return m_extensions;
+  }
+
+  [[nodiscard]] auto presentWaitEnabled() const -> bool {
+    return m_presentIdFeatures.has_value() &&
+           m_presentIdFeatures->presentId == VK_TRUE &&
+           m_presentWaitFeatures.has_value() &&
+           m_presentWaitFeatures->presentWait == VK_TRUE;
+  }
+
+  [[nodiscard]] auto multiDrawIndirectEnabled() const -> bool {
+    return pEnabledFeatures != nullptr &&
+           m_features.multiDrawIndirect == VK_TRUE;
+  }
+
+  // Through the Vulkan 1.2 feature or VK_KHR_draw_indirect_count
+  [[nodiscard]] auto drawIndirectCountEnabled() const -> bool {
+    if (m_vulkan12Features.has_value() &&
+        m_vulkan12Features->drawIndirectCount == VK_TRUE) {
+      return true;
+    }
+    return std::ranges::any_of(m_extensions, [](const char *extension) {
+      return std::string_view(extension) ==
+             VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+    });
+  }
+
   auto enableExtension(const char *extension) -> DeviceCreate & {
     m_extensions.push_back(extension);
 
@@ -179,21 +333,39 @@ public:
 
   DeviceCreate(const DeviceCreate &other)
       : VkDeviceCreateInfo{other}, m_features(other.m_features),
+        m_vulkan12Features(other.m_vulkan12Features),
+        m_vulkan13Features(other.m_vulkan13Features),
+        m_presentIdFeatures(other.m_presentIdFeatures),
+        m_presentWaitFeatures(other.m_presentWaitFeatures),
         m_queueCreateInfos(other.m_queueCreateInfos),
         m_extensions(other.m_extensions) {
-    setupQueues();
+    if (other.pEnabledFeatures != nullptr) {
+      pEnabledFeatures = &m_features;
+    }
+    setupFeatureChain();
+    setupQueueCreateInfos();
     setupExtensions();
   }
 
   DeviceCreate(DeviceCreate &&other) noexcept
       : VkDeviceCreateInfo{other}, m_features(other.m_features),
+        m_vulkan12Features(other.m_vulkan12Features),
+        m_vulkan13Features(other.m_vulkan13Features),
+        m_presentIdFeatures(other.m_presentIdFeatures),
+        m_presentWaitFeatures(other.m_presentWaitFeatures),
         m_queueCreateInfos(std::move(other.m_queueCreateInfos)),
         m_extensions(std::move(other.m_extensions)) {
     pEnabledFeatures = &m_features;
     other.pEnabledFeatures = nullptr;
-    setupQueues();
+    other.m_vulkan12Features.reset();
+    other.m_vulkan13Features.reset();
+    other.m_presentIdFeatures.reset();
+    other.m_presentWaitFeatures.reset();
+    setupFeatureChain();
+    setupQueueCreateInfos();
     setupExtensions();
-    other.setupQueues();
+    other.setupFeatureChain();
+    other.setupQueueCreateInfos();
     other.setupExtensions();
   }
 };
@@ -201,10 +373,27 @@ public:
 } // namespace info
 class Device : public RawRefable<Device, VkDevice>, public Handle<VkDevice> {
   PhysicalDevice m_physicalDevice;
+  // Cached so per-command validation does not have to query the driver
+  PhysicalDeviceProperties m_properties;
+  // Queues created per family index, zero for families without queues
+  std::vector<uint32_t> m_queueCounts;
+  std::vector<std::string> m_extensions;
+  bool m_presentWait;
+  bool m_multiDrawIndirect;
+  bool m_drawIndirectCount;
 
 public:
-  Device(VkDevice device, PhysicalDevice &physicalDevice)
-      : RawRefable(), Handle(device), m_physicalDevice(physicalDevice) {}
+  Device(VkDevice device, PhysicalDevice &physicalDevice,
+         std::vector<uint32_t> queueCounts,
+         const info::DeviceCreate &createInfo)
+      : RawRefable(), Handle(device), m_physicalDevice(physicalDevice),
+        m_properties(physicalDevice.getProperties()),
+        m_queueCounts(std::move(queueCounts)),
+        m_extensions(createInfo.extensions().begin(),
+                     createInfo.extensions().end()),
+        m_presentWait(createInfo.presentWaitEnabled()),
+        m_multiDrawIndirect(createInfo.multiDrawIndirectEnabled()),
+        m_drawIndirectCount(createInfo.drawIndirectCountEnabled()) {}
 
   void destroy() override {
     waitIdle();
@@ -217,11 +406,48 @@ public:
 
   auto getPhysical() -> PhysicalDevice & { return m_physicalDevice; }
 
+  [[nodiscard]] auto properties() const -> const PhysicalDeviceProperties & {
+    return m_properties;
+  }
+  [[nodiscard]] auto limits() const -> const VkPhysicalDeviceLimits & {
+    return m_properties.limits;
+  }
+
+  [[nodiscard]] auto hasExtension(std::string_view extension) const -> bool {
+    return std::ranges::find(m_extensions, extension) != m_extensions.end();
+  }
+
+  // VK_KHR_present_id and VK_KHR_present_wait with both features enabled
+  [[nodiscard]] auto presentWaitEnabled() const -> bool {
+    return m_presentWait;
+  }
+
+  // Indirect draws with a draw count above 1
+  [[nodiscard]] auto multiDrawIndirectEnabled() const -> bool {
+    return m_multiDrawIndirect;
+  }
+
+  // vkCmdDrawIndirectCount and vkCmdDrawIndexedIndirectCount
+  [[nodiscard]] auto drawIndirectCountEnabled() const -> bool {
+    return m_drawIndirectCount;
+  }
+
   auto getQueue(QueueFamily &family, uint32_t queueIndex)
       -> std::optional<Queue>;
   auto getQueue(int32_t queueFamilyIndex, uint32_t queueIndex)
       -> std::optional<Queue>;
 
+  // Number of queues created for the family
+  [[nodiscard]] auto queueCount(uint32_t queueFamilyIndex) const -> uint32_t {
+    return queueFamilyIndex < m_queueCounts.size()
+               ? m_queueCounts[queueFamilyIndex]
+               : 0;
+  }
+
+  // Every queue created for the family, in queue index order
+  auto getQueues(QueueFamily &family) -> std::vector<Queue>;
+  auto getQueues(uint32_t queueFamilyIndex) -> std::vector<Queue>;
+
   auto waitIdle() -> VkResult { return vkDeviceWaitIdle(m_handle); }
 
   auto createCommandPool(vk::info::CommandPoolCreate &info)
@@ -229,6 +455,8 @@ public:
   auto createSwapchain(vk::info::SwapchainCreate &info)
       -> std::optional<khr::Swapchain>;
   auto createSemaphore() -> std::optional<Semaphore>;
+  auto createTimelineSemaphore(uint64_t initialValue = 0)
+      -> std::optional<Semaphore>;
   auto createFence(bool createSignaled = false) -> std::optional<Fence>;
 
   auto createBuffer(vk::info::BufferCreate &info) -> std::optional<Buffer>;
@@ -238,6 +466,8 @@ public:
       -> std::optional<IndexBuffer>;
   auto createUniformBuffer(vk::info::UniformBufferCreate &info)
       -> std::optional<UniformBuffer>;
+  auto createIndirectBuffer(vk::info::IndirectBufferCreate &info)
+      -> std::optional<IndirectBuffer>;
 
   auto allocateMemory(Buffer &buffer, MemoryProperties properties)
       -> std::optional<DeviceMemory>;
@@ -256,5 +486,10 @@ public:
       -> std::optional<vk::DescriptorSetLayout>;
   auto createDescriptorPool(info::DescriptorPoolCreate &createInfo)
       -> std::optional<DescriptorPool>;
+
+  auto createPipelineLayout(info::PipelineLayoutCreate &createInfo)
+      -> std::optional<PipelineLayout>;
+  auto createComputePipeline(info::ComputePipelineCreate &createInfo)
+      -> std::optional<ComputePipeline>;
 };
 } // namespace vk
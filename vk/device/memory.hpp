@@ -77,6 +77,7 @@ public:
   }
 
   [[nodiscard]] auto get() const -> const void * { return m_ptr; }
+  [[nodiscard]] auto get() -> void * { return m_ptr; }
   [[nodiscard]] auto getSize() const -> Size { return m_size; }
 
   template <typename T>
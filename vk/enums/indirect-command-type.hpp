@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+class IndirectCommandType {
+public:
+  enum Values : uint8_t {
+    Draw,
+    DrawIndexed,
+    Dispatch,
+  };
+
+private:
+  Values m_value;
+
+public:
+  constexpr IndirectCommandType() : m_value(Draw) {}
+  constexpr IndirectCommandType(Values value) : m_value(value) {}
+
+  constexpr operator Values() const { return m_value; }
+
+  // Size in bytes of a single tightly packed command of this type
+  [[nodiscard]] constexpr auto stride() const -> uint32_t {
+    switch (m_value) {
+    case Draw:
+      return sizeof(VkDrawIndirectCommand);
+    case DrawIndexed:
+      return sizeof(VkDrawIndexedIndirectCommand);
+    case Dispatch:
+      return sizeof(VkDispatchIndirectCommand);
+    }
+    return 0;
+  }
+
+  [[nodiscard]] constexpr auto name() const -> const char * {
+    switch (m_value) {
+    case Draw:
+      return "Draw";
+    case DrawIndexed:
+      return "DrawIndexed";
+    case Dispatch:
+      return "Dispatch";
+    }
+    return "Unknown";
+  }
+};
+} // namespace vk
@@ -27,6 +27,15 @@ public:
 
   virtual auto destroy() -> void {}
 
+  // Destroy the object now. Unlike the destructor this dispatches to the
+  // derived `destroy`, which is no longer reachable from `~Handle`.
+  auto release() -> void {
+    if (m_handle != VK_NULL_HANDLE) {
+      destroy();
+      m_handle = VK_NULL_HANDLE;
+    }
+  }
+
   virtual ~Handle() {
     if (m_handle != VK_NULL_HANDLE) {
       destroy();
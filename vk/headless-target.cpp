@@ -0,0 +1,139 @@
+#include "headless-target.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "buffers.hpp"
+#include "device/device.hpp"
+#include "enums/memory-properties.hpp"
+
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+auto HeadlessTarget::create(Device &device, Queue queue, Extent2D extent,
+                            Format format, uint32_t imageCount,
+                            VkImageUsageFlags usage)
+    -> std::optional<HeadlessTarget> {
+  if (imageCount == 0 || extent.width == 0 || extent.height == 0) {
+    Logger::error("Headless target needs at least one non empty image");
+    return std::nullopt;
+  }
+
+  HeadlessTarget target(device, queue, extent, format);
+  target.m_images.reserve(imageCount);
+  target.m_memory.reserve(imageCount);
+  target.m_imageViews.reserve(imageCount);
+  target.m_imageSemaphores.reserve(imageCount);
+
+  for (uint32_t i = 0; i < imageCount; i++) {
+    VkImageCreateInfo imageInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = format,
+        .extent = {.width = extent.width, .height = extent.height, .depth = 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    VkImage handle;
+    if (vkCreateImage(device, &imageInfo, nullptr, &handle) != VK_SUCCESS) {
+      Logger::error("Failed to create headless image");
+      return std::nullopt;
+    }
+    // Owned by the target from here on, so failures below clean it up
+    target.m_images.push_back(Image::fromHandle(handle));
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(device, handle, &requirements);
+    auto memory = device.allocateMemory(MemoryRequirements(requirements),
+                                        MemoryProperties::DeviceLocal);
+    if (!memory.has_value()) {
+      Logger::error("Failed to allocate headless image memory");
+      return std::nullopt;
+    }
+
+    target.m_memory.push_back(std::move(memory.value()));
+
+    if (vkBindImageMemory(device, handle, target.m_memory.back(), 0) !=
+        VK_SUCCESS) {
+      Logger::error("Failed to bind headless image memory");
+      return std::nullopt;
+    }
+
+    auto viewInfo = info::ImageViewCreate(target.m_images.back(), format);
+    auto imageView = ImageView::create(device, viewInfo);
+    if (!imageView.has_value()) {
+      Logger::error("Failed to create image view for headless image");
+      return std::nullopt;
+    }
+    target.m_imageViews.push_back(std::move(imageView.value()));
+
+    auto semaphore = device.createSemaphore();
+    if (!semaphore.has_value()) {
+      Logger::error("Failed to create semaphore for headless image");
+      return std::nullopt;
+    }
+    target.m_imageSemaphores.push_back(std::move(semaphore.value()));
+  }
+
+  return target;
+}
+
+HeadlessTarget::~HeadlessTarget() {
+  for (auto &imageView : m_imageViews) {
+    imageView.release();
+  }
+  for (auto &semaphore : m_imageSemaphores) {
+    semaphore.release();
+  }
+  for (auto &image : m_images) {
+    vkDestroyImage(**m_device, image, nullptr);
+  }
+  for (auto &memory : m_memory) {
+    memory.release();
+  }
+}
+
+auto HeadlessTarget::device() -> Device & { return *m_device; }
+
+auto HeadlessTarget::acquire(Semaphore &semaphore, uint64_t /*timeout*/)
+    -> AcquiredImage {
+  uint32_t imageIndex = m_next;
+  m_next = (m_next + 1) % static_cast<uint32_t>(m_images.size());
+
+  info::Submit submitInfo;
+  submitInfo.addSignalSemaphore(semaphore);
+  auto error = m_queue.submit(submitInfo);
+
+  return {.state = error.has_value() ? VkResult(error.value()) : VK_SUCCESS,
+          .imageIndex = imageIndex,
+          .semaphore = m_imageSemaphores[imageIndex]};
+}
+
+auto HeadlessTarget::present(PresentQueue & /*queue*/,
+                             info::Present & /*presentInfo*/,
+                             uint32_t &imageIndex, VkSemaphore wait)
+    -> VkResult {
+  // Consume the render semaphore so it can be signalled again
+  info::Submit submitInfo;
+  submitInfo.addWaitSemaphore(wait, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  auto error = m_queue.submit(submitInfo);
+  if (error.has_value()) {
+    return error.value();
+  }
+
+  m_presented++;
+  m_lastPresented = imageIndex;
+  return VK_SUCCESS;
+}
+} // namespace vk
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "device/memory.hpp"
+#include "enums/format.hpp"
+#include "image-view.hpp"
+#include "image.hpp"
+#include "present-target.hpp"
+#include "queue.hpp"
+#include "ref.hpp"
+#include "structs/extent2d.hpp"
+#include "sync/semaphore.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace vk {
+class Device;
+
+// Offscreen stand-in for a swapchain, so the frame loop runs without a
+// window system, e.g. on lavapipe in CI.
+//
+// Images are plain device local images handed out round-robin. Acquiring
+// signals the semaphore with an empty submission and presenting waits on the
+// render semaphore the same way, both on `queue`. Since a signal covers
+// everything submitted before it, an image is only handed out again once the
+// previous present of it has been consumed. That only holds when frames are
+// submitted on `queue` too, so hand the frame ring the same queue for
+// graphics.
+//
+// The images are not swapchain images and PRESENT_SRC_KHR is not a valid
+// layout for them. Render passes should end in TRANSFER_SRC_OPTIMAL for
+// readback, or stay in COLOR_ATTACHMENT_OPTIMAL.
+//
+// A VK_EXT_headless_surface surface with a regular swapchain is the
+// alternative when the driver exposes it, see `khr::Surface::createHeadless`.
+class HeadlessTarget : public PresentTarget {
+  RawRef<Device, VkDevice> m_device;
+  Queue m_queue;
+  std::vector<Image> m_images;
+  std::vector<DeviceMemory> m_memory;
+  std::vector<ImageView> m_imageViews;
+  std::vector<Semaphore> m_imageSemaphores;
+  Extent2D m_extent;
+  Format m_format;
+
+  uint32_t m_next = 0;
+  uint64_t m_presented = 0;
+  std::optional<uint32_t> m_lastPresented;
+
+  HeadlessTarget(Device &device, Queue queue, Extent2D extent, Format format)
+      : m_device(device.ref()), m_queue(queue), m_extent(extent),
+        m_format(format) {}
+
+protected:
+  auto device() -> Device & override;
+
+public:
+  // `usage` defaults to rendering into the images and copying them out for
+  // readback
+  static auto create(Device &device, Queue queue, Extent2D extent,
+                     Format format, uint32_t imageCount = 3,
+                     VkImageUsageFlags usage =
+                         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                         VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+      -> std::optional<HeadlessTarget>;
+
+  HeadlessTarget(HeadlessTarget &&other) noexcept = default;
+  ~HeadlessTarget() override;
+
+  auto acquire(Semaphore &semaphore, uint64_t timeout = UINT64_MAX)
+      -> AcquiredImage override;
+  auto present(PresentQueue &queue, info::Present &presentInfo,
+               uint32_t &imageIndex, VkSemaphore wait) -> VkResult override;
+
+  auto getImages() -> std::vector<Image> & override { return m_images; }
+  auto getImageViews() -> std::vector<ImageView> & override {
+    return m_imageViews;
+  }
+  auto getImageSemaphore(uint32_t imageIndex) -> Semaphore & override {
+    return m_imageSemaphores[imageIndex];
+  }
+  auto getExtent() -> Extent2D & override { return m_extent; }
+  auto getFormat() -> Format & override { return m_format; }
+
+  // Presents so far, the benchmark's frame count
+  [[nodiscard]] auto presented() const -> uint64_t { return m_presented; }
+
+  // Image of the latest present, to read back once its frame completed
+  [[nodiscard]] auto lastPresented() const -> std::optional<uint32_t> {
+    return m_lastPresented;
+  }
+};
+} // namespace vk
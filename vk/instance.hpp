@@ -29,6 +29,11 @@ public:
     this->engineVersion = engineVersion;
     apiVersion = VK_API_VERSION_1_0;
   }
+
+  auto setApiVersion(uint32_t version) -> Application & {
+    apiVersion = version;
+    return *this;
+  }
 };
 
 class InstanceCreate : public VkInstanceCreateInfo {
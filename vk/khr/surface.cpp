@@ -22,6 +22,28 @@ auto Surface::create(Instance &instance, Window &window)
   return Surface(instance, surface);
 }
 
+auto Surface::createHeadless(Instance &instance) -> std::optional<Surface> {
+  // Not exported by every loader
+  auto createHeadlessSurface = reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>(
+      vkGetInstanceProcAddr(*instance, "vkCreateHeadlessSurfaceEXT"));
+  if (createHeadlessSurface == nullptr) {
+    return std::nullopt;
+  }
+
+  VkHeadlessSurfaceCreateInfoEXT createInfo{
+      .sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT,
+      .pNext = nullptr,
+      .flags = 0,
+  };
+
+  VkSurfaceKHR surface;
+  if (createHeadlessSurface(*instance, &createInfo, nullptr, &surface) !=
+      VK_SUCCESS) {
+    return std::nullopt;
+  }
+  return Surface(instance, surface);
+}
+
 SurfaceAttributes::SurfaceAttributes(const PhysicalDevice &physicalDevice,
                                      const Surface &surface) {
 
@@ -32,6 +32,10 @@ public:
 
   static auto create(Instance &instance, Window &window)
       -> std::optional<Surface>;
+
+  // A surface without a display, requires the instance to enable
+  // VK_EXT_headless_surface
+  static auto createHeadless(Instance &instance) -> std::optional<Surface>;
 };
 
 class SurfaceAttributes {
@@ -7,11 +7,41 @@
 #include "image-view.hpp"
 #include "image.hpp"
 
+#include <algorithm>
 #include <optional>
+#include <span>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace vk {
+namespace {
+auto presentModeName(VkPresentModeKHR mode) -> const char * {
+  switch (mode) {
+  case VK_PRESENT_MODE_IMMEDIATE_KHR:
+    return "IMMEDIATE";
+  case VK_PRESENT_MODE_MAILBOX_KHR:
+    return "MAILBOX";
+  case VK_PRESENT_MODE_FIFO_KHR:
+    return "FIFO";
+  case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+    return "FIFO_RELAXED";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+auto policyName(PresentPolicy policy) -> const char * {
+  switch (policy) {
+  case PresentPolicy::LowLatency:
+    return "low latency";
+  case PresentPolicy::Throughput:
+    return "throughput";
+  case PresentPolicy::PowerSave:
+    return "power save";
+  }
+  return "unknown";
+}
+} // namespace
 
 namespace info {
 auto SwapchainCreate::setOldSwapchain(khr::Swapchain &swapchain)
@@ -19,6 +49,81 @@ auto SwapchainCreate::setOldSwapchain(khr::Swapchain &swapchain)
   oldSwapchain = swapchain;
   return *this;
 }
+
+auto SwapchainCreate::supportsPresentMode(VkPresentModeKHR mode) const
+    -> bool {
+  return std::ranges::find(swapChainSupport.presentModes, mode) !=
+         swapChainSupport.presentModes.end();
+}
+
+auto SwapchainCreate::clampImageCount(uint32_t count) const -> uint32_t {
+  const auto &capabilities = swapChainSupport.capabilities;
+  count = std::max(count, capabilities.minImageCount);
+  if (capabilities.maxImageCount != 0) {
+    count = std::min(count, capabilities.maxImageCount);
+  }
+  return count;
+}
+
+auto SwapchainCreate::setPresentPolicy(PresentPolicy policy,
+                                       bool allowTearing,
+                                       std::optional<uint32_t> imageCount)
+    -> SwapchainCreate & {
+  auto minimum = swapChainSupport.capabilities.minImageCount;
+
+  VkPresentModeKHR mode = VK_PRESENT_MODE_FIFO_KHR;
+  uint32_t count = minimum + 1;
+
+  switch (policy) {
+  case PresentPolicy::LowLatency:
+    if (allowTearing && supportsPresentMode(VK_PRESENT_MODE_IMMEDIATE_KHR)) {
+      mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+      count = minimum;
+    } else if (supportsPresentMode(VK_PRESENT_MODE_MAILBOX_KHR)) {
+      // Mailbox needs a spare image to replace while one is on screen
+      mode = VK_PRESENT_MODE_MAILBOX_KHR;
+      count = std::max(minimum + 1, 3u);
+    }
+    break;
+  case PresentPolicy::Throughput:
+    break;
+  case PresentPolicy::PowerSave:
+    if (supportsPresentMode(VK_PRESENT_MODE_FIFO_RELAXED_KHR)) {
+      mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    }
+    count = minimum;
+    break;
+  }
+
+  presentMode = mode;
+  minImageCount = clampImageCount(imageCount.value_or(count));
+
+  Logger::info("Present policy {}: {} with {} images", policyName(policy),
+               presentModeName(presentMode), minImageCount);
+  return *this;
+}
+
+auto SwapchainCreate::setPreferredFormats(
+    std::span<const VkSurfaceFormatKHR> formats) -> SwapchainCreate & {
+  for (const auto &preferred : formats) {
+    for (const auto &available : swapChainSupport.formats) {
+      if (available.format == preferred.format &&
+          available.colorSpace == preferred.colorSpace) {
+        imageFormat = available.format;
+        imageColorSpace = available.colorSpace;
+        Logger::info("Swapchain format {} with color space {}",
+                     static_cast<int>(imageFormat),
+                     static_cast<int>(imageColorSpace));
+        return *this;
+      }
+    }
+  }
+
+  Logger::warn("None of the preferred swapchain formats are supported, "
+               "keeping format {}",
+               static_cast<int>(imageFormat));
+  return *this;
+}
 } // namespace info
 
 namespace khr {
@@ -34,8 +139,13 @@ Swapchain::Swapchain(VkSwapchainKHR swapchain, Device &device,
 
 auto Swapchain::destroy() -> void {
   if (m_handle != VK_NULL_HANDLE) {
+    // Released rather than destroyed by handle so the views and semaphores
+    // do not destroy themselves a second time
     for (auto &imageView : m_imageViews) {
-      vkDestroyImageView(**m_device, imageView, nullptr);
+      imageView.release();
+    }
+    for (auto &semaphore : m_imageSemaphores) {
+      semaphore.release();
     }
     vkDestroySwapchainKHR(**m_device, m_handle, nullptr);
   }
@@ -88,33 +198,85 @@ auto Swapchain::create(Device &device, info::SwapchainCreate info)
     semaphores.push_back(std::move(semaphore.value()));
   }
 
-  return Swapchain(swapChain, device, images, imageViews, semaphores,
-                   info.imageExtent, info.imageFormat);
+  Swapchain swapchain(swapChain, device, images, imageViews, semaphores,
+                      info.imageExtent, info.imageFormat);
+
+  // The extension entry points are not exported by the loader. Older loaders
+  // hand out trampolines for extensions that were never enabled, so only
+  // look them up when the device enabled them.
+  if (device.presentWaitEnabled()) {
+    swapchain.m_waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+        vkGetDeviceProcAddr(*device, "vkWaitForPresentKHR"));
+  }
+  if (device.hasExtension(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME)) {
+    swapchain.m_getPastPresentationTiming =
+        reinterpret_cast<PFN_vkGetPastPresentationTimingGOOGLE>(
+            vkGetDeviceProcAddr(*device, "vkGetPastPresentationTimingGOOGLE"));
+    swapchain.m_getRefreshCycleDuration =
+        reinterpret_cast<PFN_vkGetRefreshCycleDurationGOOGLE>(
+            vkGetDeviceProcAddr(*device, "vkGetRefreshCycleDurationGOOGLE"));
+  }
+
+  return swapchain;
 }
 
-auto Swapchain::createFramebuffers(RenderPass &renderPass)
-    -> std::optional<std::vector<Framebuffer>> {
-  std::vector<Framebuffer> framebuffers;
-  for (auto &imageView : m_imageViews) {
-    info::FramebufferCreate builder(renderPass, m_extent.width,
-                                    m_extent.height);
-    auto framebufferCreateInfo = builder.addAttachment(imageView);
-
-    auto framebuffer = Framebuffer::create(*m_device, framebufferCreateInfo);
-    if (!framebuffer.has_value()) {
-      Logger::error("Failed to create framebuffer!");
-      return std::nullopt;
-    }
-    framebuffers.push_back(std::move(framebuffer.value()));
+auto Swapchain::waitForPresent(uint64_t presentId, uint64_t timeout)
+    -> VkResult {
+  if (m_waitForPresent == nullptr) {
+    return VK_ERROR_EXTENSION_NOT_PRESENT;
+  }
+  return m_waitForPresent(**m_device, m_handle, presentId, timeout);
+}
+
+auto Swapchain::pastPresentationTimings()
+    -> std::vector<VkPastPresentationTimingGOOGLE> {
+  if (m_getPastPresentationTiming == nullptr) {
+    return {};
   }
 
-  return framebuffers;
+  uint32_t count = 0;
+  m_getPastPresentationTiming(**m_device, m_handle, &count, nullptr);
+  std::vector<VkPastPresentationTimingGOOGLE> timings(count);
+  if (count > 0) {
+    m_getPastPresentationTiming(**m_device, m_handle, &count, timings.data());
+    timings.resize(count);
+  }
+  return timings;
+}
+
+auto Swapchain::refreshCycleDuration() -> std::optional<uint64_t> {
+  if (m_getRefreshCycleDuration == nullptr) {
+    return std::nullopt;
+  }
+
+  VkRefreshCycleDurationGOOGLE duration;
+  if (m_getRefreshCycleDuration(**m_device, m_handle, &duration) !=
+      VK_SUCCESS) {
+    return std::nullopt;
+  }
+  return duration.refreshDuration;
+}
+
+auto Swapchain::device() -> Device & { return *m_device; }
+
+auto Swapchain::acquire(Semaphore &semaphore, uint64_t timeout)
+    -> AcquiredImage {
+  return getNextImage(&semaphore, std::nullopt, timeout);
+}
+
+auto Swapchain::present(PresentQueue &queue, info::Present &presentInfo,
+                        uint32_t &imageIndex, VkSemaphore wait) -> VkResult {
+  presentInfo.addSwapchain(m_handle)
+      .setImageIndex(imageIndex)
+      .addWaitSemaphore(wait);
+  return queue.present(presentInfo);
 }
 
 auto Swapchain::getNextImage(std::optional<Semaphore *> semaphore,
                              std::optional<Fence *> fence, uint64_t timeout)
     -> SwapchainImageState {
-  uint32_t imageIndex;
+  // Left untouched when the acquire fails
+  uint32_t imageIndex = 0;
 
   VkFence fenceHandle = fence.has_value() ? **fence : VK_NULL_HANDLE;
   VkSemaphore semaphoreHandle =
@@ -5,6 +5,7 @@
 #include "handle.hpp"
 #include "image-view.hpp"
 #include "image.hpp"
+#include "present-target.hpp"
 #include "queue.hpp"
 #include "ref.hpp"
 #include "structs/extent2d.hpp"
@@ -14,6 +15,7 @@
 
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -29,11 +31,25 @@ namespace khr {
 class Swapchain;
 }
 
+// What to trade for when picking a present mode and image count
+enum class PresentPolicy {
+  // IMMEDIATE when tearing is allowed and supported, otherwise MAILBOX.
+  // Uncapped frame rate
+  LowLatency,
+  // FIFO with one image more than the minimum so the GPU never starves
+  Throughput,
+  // FIFO_RELAXED at the minimum image count
+  PowerSave,
+};
+
 namespace info {
 class SwapchainCreate : public VkSwapchainCreateInfoKHR {
   khr::SurfaceAttributes &swapChainSupport;
   std::vector<uint32_t> m_queueFamilyIndices;
 
+  [[nodiscard]] auto supportsPresentMode(VkPresentModeKHR mode) const -> bool;
+  [[nodiscard]] auto clampImageCount(uint32_t count) const -> uint32_t;
+
 public:
   SwapchainCreate(khr::SurfaceAttributes &swapChainSupport,
                   khr::Surface &surface, bool share = false)
@@ -69,14 +85,28 @@ public:
         swapChainSupport(swapChainSupport) {}
 
   auto setImageCount(uint32_t count) -> SwapchainCreate & {
+    // A maximum of 0 means there is no limit
     if (count < swapChainSupport.capabilities.minImageCount ||
-        count > swapChainSupport.capabilities.maxImageCount) {
+        (swapChainSupport.capabilities.maxImageCount != 0 &&
+         count > swapChainSupport.capabilities.maxImageCount)) {
       return *this;
     }
     minImageCount = count;
     return *this;
   }
 
+  // Pick the present mode and image count for `policy`, falling back to FIFO,
+  // which every surface supports. `imageCount` overrides the policy's count
+  // and is clamped to the surface limits.
+  auto setPresentPolicy(PresentPolicy policy, bool allowTearing = false,
+                        std::optional<uint32_t> imageCount = std::nullopt)
+      -> SwapchainCreate &;
+
+  // Use the first of `formats` the surface supports, matching both format
+  // and color space. Keeps the current format if none is supported.
+  auto setPreferredFormats(std::span<const VkSurfaceFormatKHR> formats)
+      -> SwapchainCreate &;
+
   auto setImageFormat(Format format) -> SwapchainCreate & {
     for (const auto &availableFormat : swapChainSupport.formats) {
       if (availableFormat.format == format) {
@@ -179,7 +209,7 @@ public:
 
 } // namespace info
 namespace khr {
-class Swapchain : public Handle<VkSwapchainKHR> {
+class Swapchain : public Handle<VkSwapchainKHR>, public PresentTarget {
   RawRef<Device, VkDevice> m_device;
   std::vector<Image> m_images;
   std::vector<ImageView> m_imageViews;
@@ -187,6 +217,14 @@ class Swapchain : public Handle<VkSwapchainKHR> {
   Extent2D m_extent;
   Format m_format;
 
+  // Null unless the device enabled the extension and its features
+  PFN_vkWaitForPresentKHR m_waitForPresent = nullptr;
+  PFN_vkGetPastPresentationTimingGOOGLE m_getPastPresentationTiming = nullptr;
+  PFN_vkGetRefreshCycleDurationGOOGLE m_getRefreshCycleDuration = nullptr;
+
+protected:
+  auto device() -> Device & override;
+
 public:
   Swapchain(VkSwapchainKHR swapchain, Device &device,
             std::vector<Image> &images, std::vector<ImageView> &imageViews,
@@ -197,23 +235,50 @@ public:
 
   Swapchain(Swapchain &&o) noexcept = default;
 
-  auto getImages() -> std::vector<Image> & { return m_images; }
-  auto getImageViews() -> std::vector<ImageView> & { return m_imageViews; }
+  auto getImages() -> std::vector<Image> & override { return m_images; }
+  auto getImageViews() -> std::vector<ImageView> & override {
+    return m_imageViews;
+  }
+  auto getImageSemaphore(uint32_t imageIndex) -> Semaphore & override {
+    return m_imageSemaphores[imageIndex];
+  }
 
 public:
   static auto create(Device &device, vk::info::SwapchainCreate info)
       -> std::optional<Swapchain>;
-  auto getExtent() -> Extent2D & { return m_extent; }
-  auto getFormat() -> Format & { return m_format; }
+  auto getExtent() -> Extent2D & override { return m_extent; }
+  auto getFormat() -> Format & override { return m_format; }
+
+  auto acquire(Semaphore &semaphore, uint64_t timeout = UINT64_MAX)
+      -> AcquiredImage override;
+  auto present(PresentQueue &queue, info::Present &presentInfo,
+               uint32_t &imageIndex, VkSemaphore wait) -> VkResult override;
+
+  // VK_KHR_present_wait, see `info::DeviceCreate::enablePresentWait`
+  [[nodiscard]] auto supportsPresentWait() const -> bool override {
+    return m_waitForPresent != nullptr;
+  }
+
+  // Wait until the present tagged with `presentId` (see
+  // `info::Present::addPresentId`) has reached the display. Returns
+  // VK_TIMEOUT when it has not by `timeout`.
+  auto waitForPresent(uint64_t presentId, uint64_t timeout = UINT64_MAX)
+      -> VkResult override;
+
+  // VK_GOOGLE_display_timing
+  [[nodiscard]] auto supportsDisplayTiming() const -> bool override {
+    return m_getPastPresentationTiming != nullptr;
+  }
+
+  // Timings of presents completed since the last call. Times are in
+  // nanoseconds on the clock of the display engine, CLOCK_MONOTONIC on Linux.
+  auto pastPresentationTimings()
+      -> std::vector<VkPastPresentationTimingGOOGLE> override;
 
-  auto createFramebuffers(RenderPass &renderPass)
-      -> std::optional<std::vector<Framebuffer>>;
+  // Duration of a display refresh in nanoseconds
+  auto refreshCycleDuration() -> std::optional<uint64_t>;
 
-  struct SwapchainImageState {
-    VkResult state;
-    uint32_t imageIndex;
-    Semaphore &semaphore;
-  };
+  using SwapchainImageState = AcquiredImage;
 
   auto getNextImage(std::optional<Semaphore *> semaphore = std::nullopt,
                     std::optional<Fence *> fence = std::nullopt,
@@ -0,0 +1,44 @@
+#include "compute.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "device/device.hpp"
+#include "pipeline/layout.hpp"
+
+#include <optional>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+namespace info {
+ComputePipelineCreate::ComputePipelineCreate(
+    PipelineLayout &pipelineLayout, const PipelineShaderStageCreate &stage)
+    : VkComputePipelineCreateInfo{
+          .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+          .pNext = nullptr,
+          .flags = 0,
+          .stage = stage,
+          .layout = pipelineLayout,
+          .basePipelineHandle = VK_NULL_HANDLE,
+          .basePipelineIndex = -1},
+      m_layout(pipelineLayout.ref()) {}
+} // namespace info
+
+auto ComputePipeline::create(Device &device,
+                             vk::info::ComputePipelineCreate createInfo)
+    -> std::optional<ComputePipeline> {
+  if (createInfo.stage.stage != VK_SHADER_STAGE_COMPUTE_BIT) {
+    Logger::error("Compute pipelines require a compute shader stage");
+    return std::nullopt;
+  }
+
+  VkPipeline pipeline;
+  auto result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1,
+                                         &createInfo, nullptr, &pipeline);
+  if (result != VK_SUCCESS) {
+    Logger::error("Failed to create compute pipeline");
+    return std::nullopt;
+  }
+
+  return ComputePipeline(pipeline, device, createInfo.getLayout());
+}
+} // namespace vk
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "pipeline/pipeline.hpp"
+#include <optional>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+namespace info {
+class ComputePipelineCreate : public VkComputePipelineCreateInfo {
+  RawRef<PipelineLayout, VkPipelineLayout> m_layout;
+
+public:
+  ComputePipelineCreate(PipelineLayout &pipelineLayout,
+                        const PipelineShaderStageCreate &stage);
+
+  auto getLayout() -> PipelineLayout & { return m_layout.value(); }
+};
+} // namespace info
+
+class ComputePipeline : public Pipeline {
+public:
+  ComputePipeline(VkPipeline pipeline, Device &device, PipelineLayout &layout)
+      : Pipeline(pipeline, device, layout) {}
+
+  ComputePipeline(ComputePipeline &&other) noexcept
+      : Pipeline(std::move(other)) {}
+
+  static auto create(Device &device, info::ComputePipelineCreate createInfo)
+      -> std::optional<ComputePipeline>;
+
+  [[nodiscard]] auto bindPoint() const -> VkPipelineBindPoint override {
+    return VK_PIPELINE_BIND_POINT_COMPUTE;
+  }
+};
+} // namespace vk
@@ -20,6 +20,41 @@ GraphicsPipelineCreate::GraphicsPipelineCreate(
     PipelineMultisampleStateCreate &multisampleState,
     PipelineColorBlendStateCreate &colorBlendState,
     PipelineDynamicStateCreate &dynamicState, uint32_t subpassIndex)
+    : GraphicsPipelineCreate(pipelineLayout,
+                             static_cast<VkRenderPass>(renderPass), stages,
+                             vertexInputState, inputAssemblyState,
+                             viewportState, rasterizationState,
+                             multisampleState, colorBlendState, dynamicState,
+                             subpassIndex) {}
+
+GraphicsPipelineCreate::GraphicsPipelineCreate(
+    PipelineLayout &pipelineLayout, PipelineRenderingCreate &rendering,
+    std::span<PipelineShaderStageCreate> &stages,
+    PipelineVertexInputStateCreate &vertexInputState,
+    PipelineInputAssemblyStateCreate &inputAssemblyState,
+    PipelineViewportStateCreate &viewportState,
+    PipelineRasterizationStateCreate &rasterizationState,
+    PipelineMultisampleStateCreate &multisampleState,
+    PipelineColorBlendStateCreate &colorBlendState,
+    PipelineDynamicStateCreate &dynamicState)
+    : GraphicsPipelineCreate(pipelineLayout, VK_NULL_HANDLE, stages,
+                             vertexInputState, inputAssemblyState,
+                             viewportState, rasterizationState,
+                             multisampleState, colorBlendState, dynamicState,
+                             0) {
+  pNext = &rendering;
+}
+
+GraphicsPipelineCreate::GraphicsPipelineCreate(
+    PipelineLayout &pipelineLayout, VkRenderPass renderPass,
+    std::span<PipelineShaderStageCreate> &stages,
+    PipelineVertexInputStateCreate &vertexInputState,
+    PipelineInputAssemblyStateCreate &inputAssemblyState,
+    PipelineViewportStateCreate &viewportState,
+    PipelineRasterizationStateCreate &rasterizationState,
+    PipelineMultisampleStateCreate &multisampleState,
+    PipelineColorBlendStateCreate &colorBlendState,
+    PipelineDynamicStateCreate &dynamicState, uint32_t subpassIndex)
     : VkGraphicsPipelineCreateInfo{.sType =
                                        VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
                                    .pNext = nullptr,
@@ -9,10 +9,73 @@ namespace vk {
 class RenderPass;
 
 namespace info {
+// Attachment formats of a pipeline used with dynamic rendering, in place of a
+// `RenderPass`.
+class PipelineRenderingCreate : public VkPipelineRenderingCreateInfo {
+  std::vector<VkFormat> m_colorFormats;
+
+  void setupColorFormats() {
+    colorAttachmentCount = static_cast<uint32_t>(m_colorFormats.size());
+    pColorAttachmentFormats = m_colorFormats.data();
+  }
+
+public:
+  PipelineRenderingCreate()
+      : VkPipelineRenderingCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+            .pNext = nullptr,
+            .viewMask = 0,
+            .colorAttachmentCount = 0,
+            .pColorAttachmentFormats = nullptr,
+            .depthAttachmentFormat = VK_FORMAT_UNDEFINED,
+            .stencilAttachmentFormat = VK_FORMAT_UNDEFINED} {}
+
+  auto addColorFormat(VkFormat format) -> PipelineRenderingCreate & {
+    m_colorFormats.push_back(format);
+    setupColorFormats();
+    return *this;
+  }
+
+  auto setDepthFormat(VkFormat format) -> PipelineRenderingCreate & {
+    depthAttachmentFormat = format;
+    return *this;
+  }
+
+  auto setStencilFormat(VkFormat format) -> PipelineRenderingCreate & {
+    stencilAttachmentFormat = format;
+    return *this;
+  }
+
+  PipelineRenderingCreate(const PipelineRenderingCreate &other)
+      : VkPipelineRenderingCreateInfo{other},
+        m_colorFormats(other.m_colorFormats) {
+    setupColorFormats();
+  }
+
+  PipelineRenderingCreate(PipelineRenderingCreate &&other) noexcept
+      : VkPipelineRenderingCreateInfo{other},
+        m_colorFormats(std::move(other.m_colorFormats)) {
+    setupColorFormats();
+    other.setupColorFormats();
+  }
+};
+
 class GraphicsPipelineCreate : public VkGraphicsPipelineCreateInfo {
   RawRef<PipelineLayout, VkPipelineLayout> m_layout;
   std::vector<PipelineShaderStageCreate> m_stages;
 
+  GraphicsPipelineCreate(PipelineLayout &pipelineLayout,
+                         VkRenderPass renderPass,
+                         std::span<PipelineShaderStageCreate> &stages,
+                         PipelineVertexInputStateCreate &vertexInputState,
+                         PipelineInputAssemblyStateCreate &inputAssemblyState,
+                         PipelineViewportStateCreate &viewportState,
+                         PipelineRasterizationStateCreate &rasterizationState,
+                         PipelineMultisampleStateCreate &multisampleState,
+                         PipelineColorBlendStateCreate &colorBlendState,
+                         PipelineDynamicStateCreate &dynamicState,
+                         uint32_t subpassIndex);
+
 public:
   GraphicsPipelineCreate()
       : VkGraphicsPipelineCreateInfo{.sType =
@@ -47,6 +110,20 @@ public:
                          PipelineColorBlendStateCreate &colorBlendState,
                          PipelineDynamicStateCreate &dynamicState,
                          uint32_t subpassIndex = 0);
+
+  // For dynamic rendering. `rendering` is chained into pNext and must outlive
+  // pipeline creation, like the other state blocks.
+  GraphicsPipelineCreate(PipelineLayout &pipelineLayout,
+                         PipelineRenderingCreate &rendering,
+                         std::span<PipelineShaderStageCreate> &stages,
+                         PipelineVertexInputStateCreate &vertexInputState,
+                         PipelineInputAssemblyStateCreate &inputAssemblyState,
+                         PipelineViewportStateCreate &viewportState,
+                         PipelineRasterizationStateCreate &rasterizationState,
+                         PipelineMultisampleStateCreate &multisampleState,
+                         PipelineColorBlendStateCreate &colorBlendState,
+                         PipelineDynamicStateCreate &dynamicState);
+
   auto getLayout() -> PipelineLayout & { return m_layout.value(); }
 };
 
@@ -4,23 +4,111 @@
 
 #include "device/device.hpp"
 
+#include <algorithm>
+#include <array>
 #include <optional>
+#include <span>
 #include <vulkan/vulkan_core.h>
 
 namespace vk {
-PipelineLayout::PipelineLayout(VkPipelineLayout layout, Device &device)
-    : Handle(layout), m_device(device.ref()) {}
+PipelineLayout::PipelineLayout(
+    VkPipelineLayout layout, Device &device,
+    std::span<const VkPushConstantRange> pushConstantRanges)
+    : Handle(layout), m_device(device.ref()),
+      m_pushConstantRanges(pushConstantRanges.begin(),
+                           pushConstantRanges.end()) {}
 
 auto PipelineLayout::create(Device &device, vk::info::PipelineLayoutCreate info)
     -> std::optional<PipelineLayout> {
+  auto maxSize = device.limits().maxPushConstantsSize;
+  for (const auto &range : info.pushConstantRanges()) {
+    if (range.size == 0 || range.offset % 4 != 0 || range.size % 4 != 0) {
+      Logger::error("Push constant range (offset {}, size {}) must be a "
+                    "non-empty multiple of 4 bytes",
+                    range.offset, range.size);
+      return std::nullopt;
+    }
+
+    if (range.offset + range.size > maxSize) {
+      Logger::error("Push constant range (offset {}, size {}) exceeds the "
+                    "device limit of {} bytes",
+                    range.offset, range.size, maxSize);
+      return std::nullopt;
+    }
+  }
+
   VkPipelineLayout layout;
   if (vkCreatePipelineLayout(*device, &info, nullptr, &layout) != VK_SUCCESS) {
     Logger::error("Failed to create pipeline layout");
     return std::nullopt;
   }
 
-  PipelineLayout pipelineLayout(layout, device.ref());
+  PipelineLayout pipelineLayout(layout, device.ref(),
+                                info.pushConstantRanges());
 
   return pipelineLayout;
 }
+
+auto PipelineLayout::canPushConstants(ShaderStageFlags stages, uint32_t offset,
+                                      uint32_t size) const -> bool {
+  if (size == 0 || offset % 4 != 0 || size % 4 != 0) {
+    Logger::error("Push constant update (offset {}, size {}) must be a "
+                  "non-empty multiple of 4 bytes",
+                  offset, size);
+    return false;
+  }
+
+  auto maxSize = m_device->limits().maxPushConstantsSize;
+  if (offset + size > maxSize) {
+    Logger::error("Push constant update (offset {}, size {}) exceeds the "
+                  "device limit of {} bytes",
+                  offset, size, maxSize);
+    return false;
+  }
+
+  VkShaderStageFlags requested = stages;
+
+  // Stages covering each 4 byte word of the update. Only the words in use
+  // are cleared, push constant blocks are usually far smaller than this.
+  constexpr size_t maxWords = 1024;
+  if (size / 4 > maxWords) {
+    Logger::error("Push constant update of {} bytes is too large", size);
+    return false;
+  }
+
+  std::array<VkShaderStageFlags, maxWords> covered;
+  auto firstWord = offset / 4;
+  auto wordCount = size / 4;
+  std::fill_n(covered.begin(), wordCount, 0);
+
+  for (const auto &range : m_pushConstantRanges) {
+    auto begin = std::max(range.offset, offset);
+    auto end = std::min(range.offset + range.size, offset + size);
+    if (begin >= end) {
+      continue;
+    }
+
+    if ((requested & range.stageFlags) != range.stageFlags) {
+      Logger::error("Push constant update overlaps a range used by stages "
+                    "{:#x}, but only updates stages {:#x}",
+                    range.stageFlags, requested);
+      return false;
+    }
+
+    for (auto word = begin / 4; word < end / 4; word++) {
+      covered[word - firstWord] |= range.stageFlags;
+    }
+  }
+
+  for (size_t word = 0; word < wordCount; word++) {
+    if ((covered[word] & requested) != requested) {
+      Logger::error("Push constant update (offset {}, size {}) is not covered "
+                    "by the pipeline layout for stages {:#x}",
+                    offset, size, requested);
+      return false;
+    }
+  }
+
+  return true;
+}
 } // namespace vk
@@ -4,18 +4,27 @@
 #include "ref.hpp"
 
 #include "descriptors.hpp"
+#include "enums/shader-stage.hpp"
 
+#include <cstdint>
 #include <optional>
+#include <span>
+#include <type_traits>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace vk {
 class Device;
 
+// Every implementation supports at least this many bytes of push constants,
+// larger blocks have to be checked against `maxPushConstantsSize`.
+constexpr uint32_t MinPushConstantsSize = 128;
+
 namespace info {
 class PipelineLayoutCreate : public VkPipelineLayoutCreateInfo {
   std::vector<RawRef<DescriptorSetLayout, VkDescriptorSetLayout>> layouts;
   std::vector<VkDescriptorSetLayout> layoutHandles;
+  std::vector<VkPushConstantRange> m_pushConstantRanges;
 
   void setupLayouts() {
     setLayoutCount = static_cast<uint32_t>(layouts.size());
@@ -26,6 +35,12 @@ class PipelineLayoutCreate : public VkPipelineLayoutCreateInfo {
     pSetLayouts = layoutHandles.data();
   }
 
+  void setupPushConstantRanges() {
+    pushConstantRangeCount =
+        static_cast<uint32_t>(m_pushConstantRanges.size());
+    pPushConstantRanges = m_pushConstantRanges.data();
+  }
+
 public:
   PipelineLayoutCreate()
       : VkPipelineLayoutCreateInfo{
@@ -40,11 +55,52 @@ public:
   PipelineLayoutCreate(VkPipelineLayoutCreateInfo &&other)
       : VkPipelineLayoutCreateInfo(other) {}
 
+  PipelineLayoutCreate(const PipelineLayoutCreate &other)
+      : VkPipelineLayoutCreateInfo{other}, layouts(other.layouts),
+        m_pushConstantRanges(other.m_pushConstantRanges) {
+    if (!layouts.empty()) {
+      setupLayouts();
+    }
+    if (!m_pushConstantRanges.empty()) {
+      setupPushConstantRanges();
+    }
+  }
+
+  PipelineLayoutCreate(PipelineLayoutCreate &&other) noexcept
+      : VkPipelineLayoutCreateInfo{other}, layouts(std::move(other.layouts)),
+        layoutHandles(std::move(other.layoutHandles)),
+        m_pushConstantRanges(std::move(other.m_pushConstantRanges)) {
+    other.setupLayouts();
+    other.setupPushConstantRanges();
+  }
+
   auto addSetLayout(DescriptorSetLayout &layout) -> PipelineLayoutCreate & {
     layouts.push_back(layout.ref());
     setupLayouts();
     return *this;
   }
+
+  // `offset` and `size` must be multiples of 4
+  auto addPushConstantRange(ShaderStageFlags stages, uint32_t offset,
+                            uint32_t size) -> PipelineLayoutCreate & {
+    m_pushConstantRanges.push_back(
+        {.stageFlags = stages, .offset = offset, .size = size});
+    setupPushConstantRanges();
+    return *this;
+  }
+
+  template <typename T>
+  auto addPushConstantRange(ShaderStageFlags stages, uint32_t offset = 0)
+      -> PipelineLayoutCreate & {
+    static_assert(sizeof(T) % 4 == 0,
+                  "Push constant blocks must be a multiple of 4 bytes");
+    return addPushConstantRange(stages, offset, sizeof(T));
+  }
+
+  [[nodiscard]] auto pushConstantRanges() const
+      -> std::span<const VkPushConstantRange> {
+    return m_pushConstantRanges;
+  }
 };
 
 } // namespace info
@@ -53,8 +109,10 @@ class PipelineLayout : public Handle<VkPipelineLayout>,
                        public RawRefable<PipelineLayout, VkPipelineLayout> {
 public:
   RawRef<Device, VkDevice> m_device;
+  std::vector<VkPushConstantRange> m_pushConstantRanges;
 
-  PipelineLayout(VkPipelineLayout layout, Device &device);
+  PipelineLayout(VkPipelineLayout layout, Device &device,
+                 std::span<const VkPushConstantRange> pushConstantRanges = {});
 
 public:
   PipelineLayout(PipelineLayout &&other) noexcept = default;
@@ -64,5 +122,16 @@ public:
 
   static auto create(Device &device, info::PipelineLayoutCreate info)
       -> std::optional<PipelineLayout>;
+
+  [[nodiscard]] auto pushConstantRanges() const
+      -> std::span<const VkPushConstantRange> {
+    return m_pushConstantRanges;
+  }
+
+  // Checks that every byte of [offset, offset + size) is covered for each
+  // stage in `stages`, and that `stages` includes every stage of the ranges
+  // it overlaps, logging the reason if not.
+  [[nodiscard]] auto canPushConstants(ShaderStageFlags stages, uint32_t offset,
+                                      uint32_t size) const -> bool;
 };
 } // namespace vk
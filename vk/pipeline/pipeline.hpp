@@ -2,6 +2,7 @@
 
 #include "handle.hpp"
 #include "ref.hpp"
+#include "versioned.hpp"
 
 #include "structs/vertexInputAttributeDescription.hpp"
 #include "structs/vertexInputBindingDescription.hpp"
@@ -360,7 +361,8 @@ public:
 };
 
 class Pipeline : public Handle<VkPipeline>,
-                 public RawRefable<Pipeline, VkPipeline> {
+                 public RawRefable<Pipeline, VkPipeline>,
+                 public Versioned {
 protected:
   RawRef<Device, VkDevice> m_device;
   RawRef<PipelineLayout, VkPipelineLayout> m_layout;
@@ -371,10 +373,13 @@ public:
 
   auto destroy() -> void override {
     vkDestroyPipeline(m_device, m_handle, nullptr);
+    expireVersion();
   }
 
   [[nodiscard]] virtual auto bindPoint() const -> VkPipelineBindPoint = 0;
 
-  auto layout() -> PipelineLayout & { return m_layout.value(); }
+  [[nodiscard]] auto layout() const -> PipelineLayout & {
+    return m_layout.value();
+  }
 };
 } // namespace vk
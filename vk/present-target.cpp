@@ -0,0 +1,32 @@
+#include "present-target.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "device/device.hpp"
+#include "framebuffer.hpp"
+#include "pipeline/renderPass.hpp"
+
+#include <optional>
+#include <vector>
+
+namespace vk {
+auto PresentTarget::createFramebuffers(RenderPass &renderPass)
+    -> std::optional<std::vector<Framebuffer>> {
+  auto &extent = getExtent();
+
+  std::vector<Framebuffer> framebuffers;
+  for (auto &imageView : getImageViews()) {
+    info::FramebufferCreate builder(renderPass, extent.width, extent.height);
+    auto framebufferCreateInfo = builder.addAttachment(imageView);
+
+    auto framebuffer = Framebuffer::create(device(), framebufferCreateInfo);
+    if (!framebuffer.has_value()) {
+      Logger::error("Failed to create framebuffer!");
+      return std::nullopt;
+    }
+    framebuffers.push_back(std::move(framebuffer.value()));
+  }
+
+  return framebuffers;
+}
+} // namespace vk
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "enums/format.hpp"
+#include "image-view.hpp"
+#include "image.hpp"
+#include "queue.hpp"
+#include "structs/extent2d.hpp"
+#include "sync/semaphore.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+class Device;
+class Framebuffer;
+class RenderPass;
+
+struct AcquiredImage {
+  VkResult state;
+  uint32_t imageIndex;
+  // Semaphore tied to the image, to signal when rendering to it finishes
+  Semaphore &semaphore;
+};
+
+// Something a frame loop acquires images from and presents them to: a
+// swapchain, or a `HeadlessTarget` when there is no window system.
+class PresentTarget {
+protected:
+  virtual auto device() -> Device & = 0;
+
+public:
+  PresentTarget() = default;
+  PresentTarget(const PresentTarget &) = delete;
+  auto operator=(const PresentTarget &) -> PresentTarget & = delete;
+  PresentTarget(PresentTarget &&) noexcept = default;
+  auto operator=(PresentTarget &&) noexcept -> PresentTarget & = default;
+  virtual ~PresentTarget() = default;
+
+  // Acquire the next image, signalling `semaphore` once it can be written
+  virtual auto acquire(Semaphore &semaphore, uint64_t timeout = UINT64_MAX)
+      -> AcquiredImage = 0;
+
+  // Present `imageIndex` once `wait` is signalled. `presentInfo` may carry
+  // extension structs; targets that do not present to a display ignore it.
+  virtual auto present(PresentQueue &queue, info::Present &presentInfo,
+                       uint32_t &imageIndex, VkSemaphore wait) -> VkResult = 0;
+
+  virtual auto getImages() -> std::vector<Image> & = 0;
+  virtual auto getImageViews() -> std::vector<ImageView> & = 0;
+  virtual auto getImageSemaphore(uint32_t imageIndex) -> Semaphore & = 0;
+  virtual auto getExtent() -> Extent2D & = 0;
+  virtual auto getFormat() -> Format & = 0;
+
+  // One framebuffer per image with the image as its only attachment
+  auto createFramebuffers(RenderPass &renderPass)
+      -> std::optional<std::vector<Framebuffer>>;
+
+  // Present timing, only supported when presenting to a display
+  [[nodiscard]] virtual auto supportsPresentWait() const -> bool {
+    return false;
+  }
+  virtual auto waitForPresent(uint64_t /*presentId*/,
+                              uint64_t /*timeout*/ = UINT64_MAX) -> VkResult {
+    return VK_ERROR_EXTENSION_NOT_PRESENT;
+  }
+  [[nodiscard]] virtual auto supportsDisplayTiming() const -> bool {
+    return false;
+  }
+  virtual auto pastPresentationTimings()
+      -> std::vector<VkPastPresentationTimingGOOGLE> {
+    return {};
+  }
+};
+} // namespace vk
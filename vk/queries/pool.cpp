@@ -0,0 +1,52 @@
+#include "pool.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "device/device.hpp"
+
+#include <optional>
+#include <span>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+QueryPool::QueryPool(VkQueryPool pool, Device &device,
+                     const info::QueryPoolCreate &info)
+    : Handle(pool), m_device(device.ref()), m_type(info.queryType),
+      m_count(info.queryCount), m_statistics(info.pipelineStatistics) {}
+
+auto QueryPool::create(Device &device, info::QueryPoolCreate createInfo)
+    -> std::optional<QueryPool> {
+  if (createInfo.queryCount == 0) {
+    Logger::error("Cannot create an empty query pool");
+    return std::nullopt;
+  }
+
+  VkQueryPool pool;
+  if (vkCreateQueryPool(device, &createInfo, nullptr, &pool) != VK_SUCCESS) {
+    Logger::error("Failed to create query pool");
+    return std::nullopt;
+  }
+
+  return QueryPool(pool, device, createInfo);
+}
+
+auto QueryPool::getResults(uint32_t firstQuery, uint32_t queryCount,
+                           std::span<uint64_t> results, VkDeviceSize stride,
+                           VkQueryResultFlags flags) -> VkResult {
+  if (firstQuery + queryCount > m_count) {
+    Logger::error("Query range {}..{} is outside of the pool of {} queries",
+                  firstQuery, firstQuery + queryCount, m_count);
+    return VK_ERROR_UNKNOWN;
+  }
+
+  if (results.size_bytes() < queryCount * stride) {
+    Logger::error("Query result storage is too small for {} queries",
+                  queryCount);
+    return VK_ERROR_UNKNOWN;
+  }
+
+  return vkGetQueryPoolResults(m_device, m_handle, firstQuery, queryCount,
+                               results.size_bytes(), results.data(), stride,
+                               flags | VK_QUERY_RESULT_64_BIT);
+}
+} // namespace vk
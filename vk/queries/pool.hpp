@@ -0,0 +1,68 @@
+#pragma once
+
+#include "handle.hpp"
+#include "ref.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace vk {
+class Device;
+
+namespace info {
+class QueryPoolCreate : public VkQueryPoolCreateInfo {
+public:
+  QueryPoolCreate(VkQueryType type, uint32_t count,
+                  VkQueryPipelineStatisticFlags statistics = 0)
+      : VkQueryPoolCreateInfo{.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                              .pNext = nullptr,
+                              .flags = 0,
+                              .queryType = type,
+                              .queryCount = count,
+                              .pipelineStatistics = statistics} {}
+};
+} // namespace info
+
+class QueryPool : public Handle<VkQueryPool>,
+                  public RawRefable<QueryPool, VkQueryPool> {
+  RawRef<Device, VkDevice> m_device;
+  VkQueryType m_type;
+  uint32_t m_count;
+  VkQueryPipelineStatisticFlags m_statistics;
+
+public:
+  QueryPool(VkQueryPool pool, Device &device,
+            const info::QueryPoolCreate &info);
+
+  QueryPool(QueryPool &&other) noexcept = default;
+
+  static auto create(Device &device, info::QueryPoolCreate createInfo)
+      -> std::optional<QueryPool>;
+
+  auto destroy() -> void override {
+    vkDestroyQueryPool(m_device, m_handle, nullptr);
+  }
+
+  [[nodiscard]] auto type() const -> VkQueryType { return m_type; }
+  [[nodiscard]] auto count() const -> uint32_t { return m_count; }
+  [[nodiscard]] auto statistics() const -> VkQueryPipelineStatisticFlags {
+    return m_statistics;
+  }
+
+  // Reset queries from the host, requires Vulkan 1.2 with `hostQueryReset`
+  // enabled. The queries must not be in use by pending command buffers.
+  void reset(uint32_t firstQuery, uint32_t queryCount) {
+    vkResetQueryPool(m_device, m_handle, firstQuery, queryCount);
+  }
+
+  // Copy `queryCount` results starting at `firstQuery` into `results`, which
+  // must hold `queryCount * stride / sizeof(uint64_t)` values. Never waits
+  // unless VK_QUERY_RESULT_WAIT_BIT is passed, returns VK_NOT_READY if any
+  // of the queries has no result yet.
+  auto getResults(uint32_t firstQuery, uint32_t queryCount,
+                  std::span<uint64_t> results, VkDeviceSize stride,
+                  VkQueryResultFlags flags = 0) -> VkResult;
+};
+} // namespace vk
@@ -0,0 +1,169 @@
+#include "statistics.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "device/device.hpp"
+
+#include <bit>
+#include <optional>
+#include <string_view>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+QueryScopes::QueryScopes(QueryPool &&pool, uint32_t framesInFlight,
+                         uint32_t maxScopes, VkQueryControlFlags control)
+    : m_pool(std::move(pool)), m_maxScopes(maxScopes),
+      m_valueCount(m_pool.type() == VK_QUERY_TYPE_PIPELINE_STATISTICS
+                       ? std::popcount(m_pool.statistics())
+                       : 1),
+      m_control(control), m_frames(framesInFlight) {
+  // Values followed by an availability word for each query
+  m_readback.resize(static_cast<size_t>(maxScopes) * (m_valueCount + 1));
+}
+
+auto QueryScopes::createStatistics(Device &device, uint32_t framesInFlight,
+                                   uint32_t maxScopesPerFrame,
+                                   VkQueryPipelineStatisticFlags statistics)
+    -> std::optional<QueryScopes> {
+  if (statistics == 0) {
+    Logger::error("No pipeline statistics requested");
+    return std::nullopt;
+  }
+
+  if (framesInFlight == 0 || maxScopesPerFrame == 0) {
+    Logger::error("Query scopes need at least one frame and one scope");
+    return std::nullopt;
+  }
+
+  auto pool = QueryPool::create(
+      device, info::QueryPoolCreate(VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                                    framesInFlight * maxScopesPerFrame,
+                                    statistics));
+  if (!pool.has_value()) {
+    return std::nullopt;
+  }
+
+  pool->reset(0, pool->count());
+
+  return QueryScopes(std::move(pool.value()), framesInFlight,
+                     maxScopesPerFrame, 0);
+}
+
+auto QueryScopes::createOcclusion(Device &device, uint32_t framesInFlight,
+                                  uint32_t maxScopesPerFrame, bool precise)
+    -> std::optional<QueryScopes> {
+  if (framesInFlight == 0 || maxScopesPerFrame == 0) {
+    Logger::error("Query scopes need at least one frame and one scope");
+    return std::nullopt;
+  }
+
+  auto pool = QueryPool::create(
+      device, info::QueryPoolCreate(VK_QUERY_TYPE_OCCLUSION,
+                                    framesInFlight * maxScopesPerFrame));
+  if (!pool.has_value()) {
+    return std::nullopt;
+  }
+
+  pool->reset(0, pool->count());
+
+  return QueryScopes(std::move(pool.value()), framesInFlight,
+                     maxScopesPerFrame,
+                     precise ? VK_QUERY_CONTROL_PRECISE_BIT : 0);
+}
+
+auto QueryScopes::resolve(Frame &frame, uint32_t slot) -> bool {
+  auto queryCount = static_cast<uint32_t>(frame.names.size());
+  if (queryCount == 0) {
+    m_results.clear();
+    m_resultsFrame = frame.frameNumber;
+    return true;
+  }
+
+  VkDeviceSize stride = sizeof(uint64_t) * (m_valueCount + 1);
+  auto result =
+      m_pool.getResults(firstQuery(slot), queryCount, m_readback, stride,
+                        VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  if (result != VK_SUCCESS && result != VK_NOT_READY) {
+    Logger::error("Failed to read query results: {}",
+                  static_cast<int>(result));
+    return false;
+  }
+
+  std::vector<Scope> scopes;
+  scopes.reserve(queryCount);
+  for (uint32_t i = 0; i < queryCount; i++) {
+    const auto *values = &m_readback[static_cast<size_t>(i) *
+                                     (m_valueCount + 1)];
+    if (values[m_valueCount] == 0) {
+      return false;
+    }
+
+    scopes.push_back({.name = frame.names[i],
+                      .values = {values, values + m_valueCount}});
+  }
+
+  m_results = std::move(scopes);
+  m_resultsFrame = frame.frameNumber;
+  return true;
+}
+
+void QueryScopes::beginFrame(uint64_t frameNumber) {
+  m_current = static_cast<uint32_t>(frameNumber % m_frames.size());
+  auto &frame = m_frames[m_current];
+
+  if (frame.pending && !resolve(frame, m_current)) {
+    Logger::warn("Query results for frame {} were not ready, dropping them",
+                 frame.frameNumber);
+  }
+
+  if (m_open.has_value()) {
+    Logger::warn("Query scope was not ended last frame");
+    m_open.reset();
+  }
+
+  m_pool.reset(firstQuery(m_current), m_maxScopes);
+
+  frame.names.clear();
+  frame.frameNumber = frameNumber;
+  frame.pending = true;
+  m_skipped = 0;
+}
+
+void QueryScopes::begin(VkCommandBuffer commandBuffer, std::string_view name) {
+  if (m_open.has_value() || m_skipped > 0) {
+    Logger::error("Query scopes cannot be nested, not querying {}", name);
+    m_skipped++;
+    return;
+  }
+
+  auto &frame = m_frames[m_current];
+  if (frame.names.size() >= m_maxScopes) {
+    Logger::warn("Out of query scopes, not querying {}", name);
+    m_skipped++;
+    return;
+  }
+
+  auto index = static_cast<uint32_t>(frame.names.size());
+  frame.names.emplace_back(name);
+  m_open = index;
+
+  vkCmdBeginQuery(commandBuffer, m_pool, firstQuery(m_current) + index,
+                  m_control);
+}
+
+void QueryScopes::end(VkCommandBuffer commandBuffer) {
+  // Innermost begins are matched first
+  if (m_skipped > 0) {
+    m_skipped--;
+    return;
+  }
+
+  if (!m_open.has_value()) {
+    Logger::error("Query scope ended without being begun");
+    return;
+  }
+
+  vkCmdEndQuery(commandBuffer, m_pool, firstQuery(m_current) + *m_open);
+  m_open.reset();
+}
+} // namespace vk
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "queries/pool.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vk {
+class Device;
+
+// Named pipeline statistics or occlusion queries, one query per scope.
+//
+// Like `GpuTimer` the pool is split into one slice per frame in flight.
+// `beginFrame` reads the slice's previous results without waiting and then
+// resets it from the host, so it must only be called once the frame that
+// last used the slot has completed. Requires Vulkan 1.2 with `hostQueryReset`
+// enabled, plus `pipelineStatisticsQuery` for statistics queries.
+//
+// Queries of one type cannot be nested, so scopes of the same `QueryScopes`
+// cannot overlap.
+class QueryScopes {
+public:
+  struct Scope {
+    std::string name;
+    // One value per enabled statistic, in bit order, or the number of
+    // passing samples for occlusion queries
+    std::vector<uint64_t> values;
+  };
+
+private:
+  struct Frame {
+    std::vector<std::string> names;
+    uint64_t frameNumber = 0;
+    bool pending = false;
+  };
+
+  QueryPool m_pool;
+  uint32_t m_maxScopes;
+  uint32_t m_valueCount;
+  VkQueryControlFlags m_control;
+
+  std::vector<Frame> m_frames;
+  uint32_t m_current = 0;
+  std::optional<uint32_t> m_open;
+  // Begins that recorded nothing, nested or out of slots, each still
+  // waiting for its `end`
+  uint32_t m_skipped = 0;
+
+  std::vector<Scope> m_results;
+  std::optional<uint64_t> m_resultsFrame;
+  std::vector<uint64_t> m_readback;
+
+  QueryScopes(QueryPool &&pool, uint32_t framesInFlight, uint32_t maxScopes,
+              VkQueryControlFlags control);
+
+  [[nodiscard]] auto firstQuery(uint32_t frame) const -> uint32_t {
+    return frame * m_maxScopes;
+  }
+
+  auto resolve(Frame &frame, uint32_t slot) -> bool;
+
+public:
+  static auto createStatistics(Device &device, uint32_t framesInFlight,
+                               uint32_t maxScopesPerFrame,
+                               VkQueryPipelineStatisticFlags statistics)
+      -> std::optional<QueryScopes>;
+
+  // `precise` counts exact samples rather than any non zero value and needs
+  // the `occlusionQueryPrecise` feature.
+  static auto createOcclusion(Device &device, uint32_t framesInFlight,
+                              uint32_t maxScopesPerFrame, bool precise = false)
+      -> std::optional<QueryScopes>;
+
+  QueryScopes(QueryScopes &&other) noexcept = default;
+
+  [[nodiscard]] auto type() const -> VkQueryType { return m_pool.type(); }
+
+  // Collect the previous results of slot `frameNumber % framesInFlight` and
+  // reset it for this frame. Call before recording any scope of the frame.
+  void beginFrame(uint64_t frameNumber);
+
+  void begin(VkCommandBuffer commandBuffer, std::string_view name);
+  void end(VkCommandBuffer commandBuffer);
+
+  // Scopes of the most recently resolved frame in begin order
+  [[nodiscard]] auto results() const -> std::span<const Scope> {
+    return m_results;
+  }
+
+  [[nodiscard]] auto resultsFrame() const -> std::optional<uint64_t> {
+    return m_resultsFrame;
+  }
+
+  // Value of a single statistic in a statistics scope, if it was enabled
+  [[nodiscard]] auto statistic(const Scope &scope,
+                               VkQueryPipelineStatisticFlagBits bit) const
+      -> std::optional<uint64_t> {
+    auto enabled = m_pool.statistics();
+    if ((enabled & bit) == 0) {
+      return std::nullopt;
+    }
+    auto index = std::popcount(enabled & (bit - 1u));
+    return scope.values[index];
+  }
+};
+} // namespace vk
@@ -0,0 +1,182 @@
+#include "timestamps.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "device/device.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+GpuTimer::GpuTimer(QueryPool &&pool, uint32_t framesInFlight,
+                   uint32_t maxScopes, double period, uint32_t validBits)
+    : m_pool(std::move(pool)), m_maxScopes(maxScopes), m_period(period),
+      m_validMask(validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1),
+      m_frames(framesInFlight) {
+  m_readback.resize(static_cast<size_t>(maxScopes) * 2 * 2);
+}
+
+auto GpuTimer::create(Device &device, uint32_t framesInFlight,
+                      uint32_t maxScopesPerFrame, uint32_t timestampValidBits)
+    -> std::optional<GpuTimer> {
+  if (timestampValidBits == 0) {
+    Logger::error("Queue family does not support timestamps");
+    return std::nullopt;
+  }
+
+  if (framesInFlight == 0 || maxScopesPerFrame == 0) {
+    Logger::error("GPU timer needs at least one frame and one scope");
+    return std::nullopt;
+  }
+
+  auto pool = QueryPool::create(
+      device, info::QueryPoolCreate(VK_QUERY_TYPE_TIMESTAMP,
+                                    framesInFlight * maxScopesPerFrame * 2));
+  if (!pool.has_value()) {
+    return std::nullopt;
+  }
+
+  return GpuTimer(std::move(pool.value()), framesInFlight, maxScopesPerFrame,
+                  device.limits().timestampPeriod, timestampValidBits);
+}
+
+auto GpuTimer::resolve(Frame &frame, uint32_t slot) -> bool {
+  auto queryCount = static_cast<uint32_t>(frame.scopes.size() * 2);
+  if (queryCount == 0) {
+    m_results.clear();
+    m_resultsFrame = frame.frameNumber;
+    return true;
+  }
+
+  // Value and availability pairs
+  constexpr VkDeviceSize stride = sizeof(uint64_t) * 2;
+  auto result = m_pool.getResults(firstQuery(slot), queryCount, m_readback,
+                                  stride,
+                                  VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  if (result != VK_SUCCESS && result != VK_NOT_READY) {
+    Logger::error("Failed to read GPU timestamps: {}",
+                  static_cast<int>(result));
+    return false;
+  }
+
+  auto base = firstQuery(slot);
+  auto timestamp = [&](uint32_t query) -> std::optional<uint64_t> {
+    auto index = static_cast<size_t>(query - base) * 2;
+    if (m_readback[index + 1] == 0) {
+      return std::nullopt;
+    }
+    return m_readback[index] & m_validMask;
+  };
+
+  std::vector<Scope> scopes;
+  scopes.reserve(frame.scopes.size());
+  for (const auto &pending : frame.scopes) {
+    auto begin = timestamp(pending.beginQuery);
+    auto end = timestamp(pending.endQuery);
+    if (!pending.ended || !begin.has_value() || !end.has_value()) {
+      return false;
+    }
+
+    // Masking handles counters that wrap within their valid bits
+    auto ticks = (end.value() - begin.value()) & m_validMask;
+    scopes.push_back({.name = pending.name,
+                      .parent = pending.parent,
+                      .depth = pending.depth,
+                      .milliseconds =
+                          static_cast<double>(ticks) * m_period / 1e6});
+  }
+
+  m_results = std::move(scopes);
+  m_resultsFrame = frame.frameNumber;
+  return true;
+}
+
+void GpuTimer::beginFrame(VkCommandBuffer commandBuffer, uint64_t frameNumber) {
+  m_current = static_cast<uint32_t>(frameNumber % m_frames.size());
+  m_frameNumber = frameNumber;
+  auto &frame = m_frames[m_current];
+
+  if (frame.pending && !resolve(frame, m_current)) {
+    Logger::warn("GPU timings for frame {} were not ready, dropping them",
+                 frame.frameNumber);
+  }
+
+  if (!m_open.empty()) {
+    Logger::warn("{} GPU timer scopes were not ended last frame",
+                 m_open.size());
+    m_open.clear();
+  }
+
+  vkCmdResetQueryPool(commandBuffer, m_pool, firstQuery(m_current),
+                      m_maxScopes * 2);
+
+  frame.scopes.clear();
+  frame.frameNumber = frameNumber;
+  frame.pending = true;
+}
+
+void GpuTimer::beginScope(VkCommandBuffer commandBuffer,
+                          std::string_view name) {
+  auto &frame = m_frames[m_current];
+
+  if (frame.scopes.size() >= m_maxScopes) {
+    Logger::warn("Out of GPU timer scopes, not timing {}", name);
+    m_open.push_back(NoParent);
+    return;
+  }
+
+  auto index = static_cast<uint32_t>(frame.scopes.size());
+  auto query = firstQuery(m_current) + index * 2;
+
+  // The innermost scope that is actually being timed
+  uint32_t parent = NoParent;
+  for (auto it = m_open.rbegin(); it != m_open.rend(); it++) {
+    if (*it != NoParent) {
+      parent = *it;
+      break;
+    }
+  }
+
+  frame.scopes.push_back(
+      {.name = std::string(name),
+       .parent = parent,
+       .depth = parent == NoParent ? 0 : frame.scopes[parent].depth + 1,
+       .beginQuery = query,
+       .endQuery = query + 1,
+       .ended = false});
+  m_open.push_back(index);
+
+  vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT,
+                       m_pool, query);
+}
+
+void GpuTimer::endScope(VkCommandBuffer commandBuffer) {
+  if (m_open.empty()) {
+    Logger::error("GPU timer scope ended without being begun");
+    return;
+  }
+
+  auto index = m_open.back();
+  m_open.pop_back();
+  if (index == NoParent) {
+    return;
+  }
+
+  auto &scope = m_frames[m_current].scopes[index];
+  scope.ended = true;
+
+  vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
+                       m_pool, scope.endQuery);
+}
+
+auto GpuTimer::report() const -> std::string {
+  std::string out;
+  for (const auto &scope : m_results) {
+    out += fmt::format("{:{}}{}: {:.3f}ms\n", "", scope.depth * 2, scope.name,
+                       scope.milliseconds);
+  }
+  return out;
+}
+} // namespace vk
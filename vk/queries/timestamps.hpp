@@ -0,0 +1,106 @@
+#pragma once
+
+#include "queries/pool.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vk {
+class Device;
+
+// Named, nested GPU timings backed by a timestamp query pool.
+//
+// The pool is split into one slice per frame in flight. `beginFrame` reads
+// back the slice's previous results without waiting and then resets it, so as
+// long as the caller only reuses a frame slot after that frame's fence has
+// signalled, reading results never stalls.
+class GpuTimer {
+public:
+  static constexpr uint32_t NoParent = UINT32_MAX;
+
+  struct Scope {
+    std::string name;
+    // Index of the enclosing scope in the same frame, or `NoParent`
+    uint32_t parent;
+    uint32_t depth;
+    double milliseconds;
+  };
+
+private:
+  struct PendingScope {
+    std::string name;
+    uint32_t parent;
+    uint32_t depth;
+    uint32_t beginQuery;
+    uint32_t endQuery;
+    bool ended;
+  };
+
+  struct Frame {
+    std::vector<PendingScope> scopes;
+    uint64_t frameNumber = 0;
+    bool pending = false;
+  };
+
+  QueryPool m_pool;
+  uint32_t m_maxScopes;
+  double m_period;
+  uint64_t m_validMask;
+
+  std::vector<Frame> m_frames;
+  uint32_t m_current = 0;
+  uint64_t m_frameNumber = 0;
+  // Scopes without an end timestamp yet, innermost last. Scopes dropped for
+  // lack of queries are pushed as `NoParent` so begin/end stay balanced.
+  std::vector<uint32_t> m_open;
+
+  std::vector<Scope> m_results;
+  std::optional<uint64_t> m_resultsFrame;
+  std::vector<uint64_t> m_readback;
+
+  GpuTimer(QueryPool &&pool, uint32_t framesInFlight, uint32_t maxScopes,
+           double period, uint32_t validBits);
+
+  [[nodiscard]] auto firstQuery(uint32_t frame) const -> uint32_t {
+    return frame * m_maxScopes * 2;
+  }
+
+  auto resolve(Frame &frame, uint32_t slot) -> bool;
+
+public:
+  // `timestampValidBits` comes from the properties of the queue family the
+  // timed command buffers are submitted to.
+  static auto create(Device &device, uint32_t framesInFlight,
+                     uint32_t maxScopesPerFrame, uint32_t timestampValidBits)
+      -> std::optional<GpuTimer>;
+
+  GpuTimer(GpuTimer &&other) noexcept = default;
+
+  // Start recording frame `frameNumber` into slot `frameNumber %
+  // framesInFlight`, collecting that slot's previous results if available.
+  // Must be recorded outside of a render pass, before any scope of the frame.
+  void beginFrame(VkCommandBuffer commandBuffer, uint64_t frameNumber);
+
+  void beginScope(VkCommandBuffer commandBuffer, std::string_view name);
+  void endScope(VkCommandBuffer commandBuffer);
+
+  // Scopes of the most recently resolved frame in begin order, so a scope's
+  // children always follow it.
+  [[nodiscard]] auto results() const -> std::span<const Scope> {
+    return m_results;
+  }
+
+  // Frame number the current results belong to
+  [[nodiscard]] auto resultsFrame() const -> std::optional<uint64_t> {
+    return m_resultsFrame;
+  }
+
+  // The results as an indented "name: 1.234ms" line per scope, for logging
+  [[nodiscard]] auto report() const -> std::string;
+};
+} // namespace vk
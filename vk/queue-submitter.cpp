@@ -0,0 +1,81 @@
+#include "queue-submitter.hpp"
+
+#include "sync/fence.hpp"
+
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+
+namespace vk {
+QueueSubmitter::QueueSubmitter(std::span<const Queue> queues) {
+  assert(!queues.empty());
+
+  m_slots.reserve(queues.size());
+  for (const auto &queue : queues) {
+    m_slots.push_back(std::make_unique<Slot>(queue));
+  }
+}
+
+auto QueueSubmitter::pick() -> Locked {
+  auto count = static_cast<uint32_t>(m_slots.size());
+  uint32_t start = m_next.fetch_add(1, std::memory_order_relaxed) % count;
+
+  for (uint32_t i = 0; i < count; i++) {
+    auto &slot = *m_slots[(start + i) % count];
+    std::unique_lock lock(slot.mutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+      return {std::move(lock), slot.queue};
+    }
+  }
+
+  // Every queue is busy, wait behind the round-robin choice
+  return lock(start);
+}
+
+auto QueueSubmitter::lock(uint32_t index) -> Locked {
+  assert(index < m_slots.size());
+
+  auto &slot = *m_slots[index];
+  return {std::unique_lock(slot.mutex), slot.queue};
+}
+
+auto QueueSubmitter::submit(info::Submit &submitInfo,
+                            std::optional<Fence *> fence)
+    -> std::optional<errors::Submit> {
+  auto queue = pick();
+  return queue->submit(submitInfo, fence);
+}
+
+auto QueueSubmitter::submit(uint32_t index, info::Submit &submitInfo,
+                            std::optional<Fence *> fence)
+    -> std::optional<errors::Submit> {
+  auto queue = lock(index);
+  return queue->submit(submitInfo, fence);
+}
+
+auto QueueSubmitter::submit2(const info::Submit2 &submitInfo,
+                             std::optional<Fence *> fence)
+    -> std::optional<errors::Submit> {
+  auto queue = pick();
+  return queue->submit2(submitInfo, fence);
+}
+
+auto QueueSubmitter::submit2(uint32_t index, const info::Submit2 &submitInfo,
+                             std::optional<Fence *> fence)
+    -> std::optional<errors::Submit> {
+  auto queue = lock(index);
+  return queue->submit2(submitInfo, fence);
+}
+
+auto QueueSubmitter::waitIdle() -> std::optional<errors::QueueWait> {
+  for (uint32_t i = 0; i < m_slots.size(); i++) {
+    auto queue = lock(i);
+    if (auto error = queue->waitIdle(); error.has_value()) {
+      return error;
+    }
+  }
+  return std::nullopt;
+}
+} // namespace vk
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "queue.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace vk {
+class Fence;
+
+// Internally synchronized front-end for one or more queues of a family, so
+// several threads can submit without coordinating.
+//
+// `VkQueue` needs external synchronization, which is provided by a short
+// critical section per queue held only for the submit call itself. Unpinned
+// submissions go round-robin over the queues, skipping ones another thread
+// is currently submitting to. Since that gives no ordering between
+// submissions, anything that has to run in order either uses semaphores or
+// is pinned to a queue with the `index` overloads.
+//
+// The locks only help if every submission, present and wait on a managed
+// queue goes through the submitter. `engine::UploadService`,
+// `engine::AsyncCompute`, `engine::SubmitBatcher` and `engine::FrameRing`
+// submit to their `Queue` directly, so give them queues the submitter does
+// not manage.
+class QueueSubmitter {
+  struct Slot {
+    Queue queue;
+    std::mutex mutex;
+
+    explicit Slot(Queue queue) : queue(queue) {}
+  };
+
+  // Heap allocated since mutexes cannot move
+  std::vector<std::unique_ptr<Slot>> m_slots;
+  std::atomic<uint32_t> m_next = 0;
+
+public:
+  // Exclusive access to one queue, e.g. to present or to bind sparse memory
+  class Locked {
+    std::unique_lock<std::mutex> m_lock;
+    Queue *m_queue;
+
+  public:
+    Locked(std::unique_lock<std::mutex> &&lock, Queue &queue)
+        : m_lock(std::move(lock)), m_queue(&queue) {}
+
+    auto operator*() -> Queue & { return *m_queue; }
+    auto operator->() -> Queue * { return m_queue; }
+  };
+
+private:
+  auto pick() -> Locked;
+
+public:
+  explicit QueueSubmitter(std::span<const Queue> queues);
+
+  QueueSubmitter(const QueueSubmitter &) = delete;
+  auto operator=(const QueueSubmitter &) -> QueueSubmitter & = delete;
+
+  [[nodiscard]] auto queueCount() const -> uint32_t {
+    return static_cast<uint32_t>(m_slots.size());
+  }
+
+  auto submit(info::Submit &submitInfo,
+              std::optional<Fence *> fence = std::nullopt)
+      -> std::optional<errors::Submit>;
+  auto submit(uint32_t index, info::Submit &submitInfo,
+              std::optional<Fence *> fence = std::nullopt)
+      -> std::optional<errors::Submit>;
+
+  auto submit2(const info::Submit2 &submitInfo,
+               std::optional<Fence *> fence = std::nullopt)
+      -> std::optional<errors::Submit>;
+  auto submit2(uint32_t index, const info::Submit2 &submitInfo,
+               std::optional<Fence *> fence = std::nullopt)
+      -> std::optional<errors::Submit>;
+
+  auto lock(uint32_t index) -> Locked;
+
+  // Wait for every queue; takes each lock in turn
+  auto waitIdle() -> std::optional<errors::QueueWait>;
+};
+} // namespace vk
@@ -53,6 +53,32 @@ auto Queue::submit(CommandBuffer &cmdBuffer, std::optional<Fence *> fence)
   return submit(submitInfo, fence);
 }
 
+auto Queue::submit2(const vk::info::Submit2 &submitInfo,
+                    std::optional<Fence *> fence)
+    -> std::optional<errors::Submit> {
+  const VkSubmitInfo2 &info = submitInfo;
+  return submit2(std::span<const VkSubmitInfo2>(&info, 1), fence);
+}
+
+auto Queue::submit2(std::span<const VkSubmitInfo2> submitInfos,
+                    std::optional<Fence *> fence)
+    -> std::optional<errors::Submit> {
+  if (submitInfos.empty() && !fence.has_value()) {
+    return std::nullopt;
+  }
+
+  VkFence vkFence = fence.has_value() ? **fence : VK_NULL_HANDLE;
+
+  VkResult res =
+      vkQueueSubmit2(m_handle, static_cast<uint32_t>(submitInfos.size()),
+                     submitInfos.data(), vkFence);
+  if (res != VK_SUCCESS) {
+    return std::bit_cast<errors::Submit>(res);
+  }
+
+  return std::nullopt;
+}
+
 auto QueueFamily::canPresentTo(khr::Surface &surface) const -> bool {
   VkBool32 presentSupport = false;
   vkGetPhysicalDeviceSurfaceSupportKHR(device, index, surface, &presentSupport);
@@ -98,4 +124,47 @@ auto QueueFamilies::getGraphicsPresent(khr::Surface &surface)
 
   return std::nullopt;
 }
+
+auto QueueFamilies::getCompute() -> std::optional<QueueFamily> {
+  auto queue = std::ranges::find_if(m_families, [](const QueueFamily &family) {
+    return family.isCompute() && !family.hasGraphics();
+  });
+
+  if (queue == m_families.end()) {
+    queue = std::ranges::find_if(m_families, [](const QueueFamily &family) {
+      return family.isCompute();
+    });
+  }
+
+  if (queue != m_families.end()) {
+    return std::make_optional(*queue);
+  }
+
+  return std::nullopt;
+}
+
+auto QueueFamilies::getTransfer() -> std::optional<QueueFamily> {
+  auto queue = std::ranges::find_if(m_families, [](const QueueFamily &family) {
+    return family.hasTransfer() && !family.hasGraphics() &&
+           !family.isCompute();
+  });
+
+  if (queue == m_families.end()) {
+    queue = std::ranges::find_if(m_families, [](const QueueFamily &family) {
+      return family.hasTransfer() && !family.hasGraphics();
+    });
+  }
+
+  if (queue == m_families.end()) {
+    queue = std::ranges::find_if(m_families, [](const QueueFamily &family) {
+      return family.hasTransfer();
+    });
+  }
+
+  if (queue != m_families.end()) {
+    return std::make_optional(*queue);
+  }
+
+  return std::nullopt;
+}
 } // namespace vk
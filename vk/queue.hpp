@@ -5,8 +5,10 @@
 #include <algorithm>
 #include <bit>
 #include <cstdint>
+#include <optional>
 #include <span>
 #include <utility>
+#include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace vk {
@@ -20,6 +22,12 @@ class Submit : public VkSubmitInfo {
   std::vector<VkSemaphore> signalSemaphores;
   std::vector<VkPipelineStageFlags> waitDstStageMasks;
 
+  // Values for timeline semaphores, ignored for binary ones. Only chained
+  // when at least one timeline semaphore was added.
+  std::vector<uint64_t> waitValues;
+  std::vector<uint64_t> signalValues;
+  std::optional<VkTimelineSemaphoreSubmitInfo> timeline;
+
   void setupCommandBuffers() {
     commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
     pCommandBuffers = commandBuffers.empty() ? nullptr : commandBuffers.data();
@@ -38,6 +46,35 @@ class Submit : public VkSubmitInfo {
         signalSemaphores.empty() ? nullptr : signalSemaphores.data();
   }
 
+  void setupTimeline() {
+    if (!timeline.has_value()) {
+      pNext = nullptr;
+      return;
+    }
+
+    timeline->waitSemaphoreValueCount =
+        static_cast<uint32_t>(waitValues.size());
+    timeline->pWaitSemaphoreValues =
+        waitValues.empty() ? nullptr : waitValues.data();
+    timeline->signalSemaphoreValueCount =
+        static_cast<uint32_t>(signalValues.size());
+    timeline->pSignalSemaphoreValues =
+        signalValues.empty() ? nullptr : signalValues.data();
+    pNext = &timeline.value();
+  }
+
+  void enableTimeline() {
+    if (!timeline.has_value()) {
+      timeline = VkTimelineSemaphoreSubmitInfo{
+          .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+          .pNext = nullptr,
+          .waitSemaphoreValueCount = 0,
+          .pWaitSemaphoreValues = nullptr,
+          .signalSemaphoreValueCount = 0,
+          .pSignalSemaphoreValues = nullptr};
+    }
+  }
+
 public:
   Submit()
       : VkSubmitInfo{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
@@ -60,13 +97,36 @@ public:
       -> Submit & {
     waitSemaphores.push_back(semaphore);
     waitDstStageMasks.push_back(stage);
+    waitValues.push_back(0);
     setupWaitSemaphores();
+    setupTimeline();
+    return *this;
+  }
+
+  // Wait until a timeline semaphore reaches `value`
+  auto addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags stage,
+                        uint64_t value) -> Submit & {
+    enableTimeline();
+    addWaitSemaphore(semaphore, stage);
+    waitValues.back() = value;
+    setupTimeline();
     return *this;
   }
 
   auto addSignalSemaphore(VkSemaphore semaphore) -> Submit & {
     signalSemaphores.push_back(semaphore);
+    signalValues.push_back(0);
     setupSignalSemaphores();
+    setupTimeline();
+    return *this;
+  }
+
+  // Set a timeline semaphore to `value` once the submission completes
+  auto addSignalSemaphore(VkSemaphore semaphore, uint64_t value) -> Submit & {
+    enableTimeline();
+    addSignalSemaphore(semaphore);
+    signalValues.back() = value;
+    setupTimeline();
     return *this;
   }
 
@@ -74,28 +134,151 @@ public:
       : VkSubmitInfo{other}, commandBuffers(other.commandBuffers),
         waitSemaphores(other.waitSemaphores),
         signalSemaphores(other.signalSemaphores),
-        waitDstStageMasks(other.waitDstStageMasks) {
+        waitDstStageMasks(other.waitDstStageMasks),
+        waitValues(other.waitValues), signalValues(other.signalValues),
+        timeline(other.timeline) {
     setupCommandBuffers();
     setupWaitSemaphores();
     setupSignalSemaphores();
+    setupTimeline();
   }
 
   Submit(Submit &&other) noexcept
       : VkSubmitInfo{other}, commandBuffers(std::move(other.commandBuffers)),
         waitSemaphores(std::move(other.waitSemaphores)),
         signalSemaphores(std::move(other.signalSemaphores)),
-        waitDstStageMasks(std::move(other.waitDstStageMasks)) {
+        waitDstStageMasks(std::move(other.waitDstStageMasks)),
+        waitValues(std::move(other.waitValues)),
+        signalValues(std::move(other.signalValues)),
+        timeline(other.timeline) {
     setupCommandBuffers();
     setupWaitSemaphores();
     setupSignalSemaphores();
+    setupTimeline();
     other.setupCommandBuffers();
     other.setupWaitSemaphores();
     other.setupSignalSemaphores();
+    other.setupTimeline();
+  }
+};
+
+// Synchronization2 submission, requires Vulkan 1.3 with `synchronization2`
+// enabled. Binary and timeline semaphores share the same wait and signal
+// lists, with the value ignored for binary ones.
+class Submit2 : public VkSubmitInfo2 {
+  std::vector<VkCommandBufferSubmitInfo> commandBuffers;
+  std::vector<VkSemaphoreSubmitInfo> waitSemaphores;
+  std::vector<VkSemaphoreSubmitInfo> signalSemaphores;
+
+  void setupArrays() {
+    commandBufferInfoCount = static_cast<uint32_t>(commandBuffers.size());
+    pCommandBufferInfos =
+        commandBuffers.empty() ? nullptr : commandBuffers.data();
+    waitSemaphoreInfoCount = static_cast<uint32_t>(waitSemaphores.size());
+    pWaitSemaphoreInfos =
+        waitSemaphores.empty() ? nullptr : waitSemaphores.data();
+    signalSemaphoreInfoCount = static_cast<uint32_t>(signalSemaphores.size());
+    pSignalSemaphoreInfos =
+        signalSemaphores.empty() ? nullptr : signalSemaphores.data();
+  }
+
+  static auto semaphoreInfo(VkSemaphore semaphore, VkPipelineStageFlags2 stages,
+                            uint64_t value) -> VkSemaphoreSubmitInfo {
+    return {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .pNext = nullptr,
+            .semaphore = semaphore,
+            .value = value,
+            .stageMask = stages,
+            .deviceIndex = 0};
+  }
+
+public:
+  Submit2()
+      : VkSubmitInfo2{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                      .pNext = nullptr,
+                      .flags = 0,
+                      .waitSemaphoreInfoCount = 0,
+                      .pWaitSemaphoreInfos = nullptr,
+                      .commandBufferInfoCount = 0,
+                      .pCommandBufferInfos = nullptr,
+                      .signalSemaphoreInfoCount = 0,
+                      .pSignalSemaphoreInfos = nullptr} {}
+
+  auto addCommandBuffer(VkCommandBuffer commandBuffer) -> Submit2 & {
+    commandBuffers.push_back(
+        {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+         .pNext = nullptr,
+         .commandBuffer = commandBuffer,
+         .deviceMask = 0});
+    setupArrays();
+    return *this;
+  }
+
+  auto addWaitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags2 stages,
+                        uint64_t value = 0) -> Submit2 & {
+    waitSemaphores.push_back(semaphoreInfo(semaphore, stages, value));
+    setupArrays();
+    return *this;
+  }
+
+  auto addSignalSemaphore(VkSemaphore semaphore, uint64_t value = 0,
+                          VkPipelineStageFlags2 stages =
+                              VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT)
+      -> Submit2 & {
+    signalSemaphores.push_back(semaphoreInfo(semaphore, stages, value));
+    setupArrays();
+    return *this;
+  }
+
+  [[nodiscard]] auto empty() const -> bool {
+    return commandBuffers.empty() && waitSemaphores.empty() &&
+           signalSemaphores.empty();
+  }
+
+  Submit2(const Submit2 &other)
+      : VkSubmitInfo2{other}, commandBuffers(other.commandBuffers),
+        waitSemaphores(other.waitSemaphores),
+        signalSemaphores(other.signalSemaphores) {
+    setupArrays();
+  }
+
+  Submit2(Submit2 &&other) noexcept
+      : VkSubmitInfo2{other}, commandBuffers(std::move(other.commandBuffers)),
+        waitSemaphores(std::move(other.waitSemaphores)),
+        signalSemaphores(std::move(other.signalSemaphores)) {
+    setupArrays();
+    other.setupArrays();
   }
 };
+
 class Present : public VkPresentInfoKHR {
   std::vector<VkSwapchainKHR> swapchains;
   std::vector<VkSemaphore> waitSemaphores;
+  std::vector<uint64_t> presentIds;
+  std::vector<VkPresentTimeGOOGLE> presentTimes;
+  std::optional<VkPresentIdKHR> presentIdInfo;
+  std::optional<VkPresentTimesInfoGOOGLE> presentTimesInfo;
+
+  void setupChain() {
+    const void *next = nullptr;
+
+    if (presentIdInfo.has_value()) {
+      presentIdInfo->swapchainCount = static_cast<uint32_t>(presentIds.size());
+      presentIdInfo->pPresentIds = presentIds.data();
+      presentIdInfo->pNext = next;
+      next = &presentIdInfo.value();
+    }
+
+    if (presentTimesInfo.has_value()) {
+      presentTimesInfo->swapchainCount =
+          static_cast<uint32_t>(presentTimes.size());
+      presentTimesInfo->pTimes = presentTimes.data();
+      presentTimesInfo->pNext = next;
+      next = &presentTimesInfo.value();
+    }
+
+    pNext = next;
+  }
 
   void setupSwapchains() {
     swapchainCount = static_cast<uint32_t>(swapchains.size());
@@ -141,20 +324,57 @@ public:
     return *this;
   }
 
+  // Identify the present of the next swapchain in `addSwapchain` order, for
+  // `Swapchain::waitForPresent`. Ids have to increase per swapchain, 0 means
+  // none. Requires VK_KHR_present_id with `presentId` enabled.
+  auto addPresentId(uint64_t id) -> Present & {
+    presentIds.push_back(id);
+    if (!presentIdInfo.has_value()) {
+      presentIdInfo = VkPresentIdKHR{.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR};
+    }
+    setupChain();
+    return *this;
+  }
+
+  // Requires VK_GOOGLE_display_timing. A desired time of 0 presents as soon
+  // as possible while still reporting the timing of the present.
+  auto addPresentTime(uint32_t presentId, uint64_t desiredPresentTime = 0)
+      -> Present & {
+    presentTimes.push_back({.presentID = presentId,
+                            .desiredPresentTime = desiredPresentTime});
+    if (!presentTimesInfo.has_value()) {
+      presentTimesInfo = VkPresentTimesInfoGOOGLE{
+          .sType = VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE};
+    }
+    setupChain();
+    return *this;
+  }
+
   Present(const Present &other)
       : VkPresentInfoKHR{other}, swapchains(other.swapchains),
-        waitSemaphores(other.waitSemaphores) {
+        waitSemaphores(other.waitSemaphores), presentIds(other.presentIds),
+        presentTimes(other.presentTimes), presentIdInfo(other.presentIdInfo),
+        presentTimesInfo(other.presentTimesInfo) {
     setupSwapchains();
     setupWaitSemaphores();
+    setupChain();
   }
 
   Present(Present &&other) noexcept
       : VkPresentInfoKHR{other}, swapchains(std::move(other.swapchains)),
-        waitSemaphores(std::move(other.waitSemaphores)) {
+        waitSemaphores(std::move(other.waitSemaphores)),
+        presentIds(std::move(other.presentIds)),
+        presentTimes(std::move(other.presentTimes)),
+        presentIdInfo(other.presentIdInfo),
+        presentTimesInfo(other.presentTimesInfo) {
     setupSwapchains();
     setupWaitSemaphores();
+    setupChain();
+    other.presentIdInfo.reset();
+    other.presentTimesInfo.reset();
     other.setupSwapchains();
     other.setupWaitSemaphores();
+    other.setupChain();
   }
 };
 
@@ -202,6 +422,16 @@ public:
               std::optional<Fence *> fence = std::nullopt)
       -> std::optional<errors::Submit>;
 
+  // vkQueueSubmit2, requires Vulkan 1.3 with `synchronization2` enabled
+  auto submit2(const vk::info::Submit2 &submitInfo,
+               std::optional<Fence *> fence = std::nullopt)
+      -> std::optional<errors::Submit>;
+
+  // Raw infos so callers can batch without copying builders around
+  auto submit2(std::span<const VkSubmitInfo2> submitInfos,
+               std::optional<Fence *> fence = std::nullopt)
+      -> std::optional<errors::Submit>;
+
   auto waitIdle() -> std::optional<errors::QueueWait> {
     auto res = vkQueueWaitIdle(m_handle);
     if (res != VK_SUCCESS) {
@@ -256,6 +486,14 @@ public:
   [[nodiscard]] auto hasGraphics() const -> bool {
     return family.queueFlags & VK_QUEUE_GRAPHICS_BIT;
   }
+
+  // Graphics and compute queues support transfers even when the transfer bit
+  // is not reported
+  [[nodiscard]] auto hasTransfer() const -> bool {
+    return family.queueFlags &
+           (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT |
+            VK_QUEUE_COMPUTE_BIT);
+  }
 };
 
 class QueueFamilies {
@@ -283,5 +521,12 @@ public:
   auto getGraphics() -> std::optional<QueueFamily>;
   auto getPresent(khr::Surface &surface) -> std::optional<QueueFamily>;
   auto getGraphicsPresent(khr::Surface &surface) -> std::optional<QueueFamily>;
+
+  // Prefers a compute family without graphics, which runs asynchronously to
+  // graphics work, then falls back to any compute family.
+  auto getCompute() -> std::optional<QueueFamily>;
+  // Prefers a transfer only family, usually backed by a DMA engine, then one
+  // without graphics, then any family.
+  auto getTransfer() -> std::optional<QueueFamily>;
 };
 } // namespace vk
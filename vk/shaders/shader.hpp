@@ -18,6 +18,7 @@ public:
     Geometry = VK_SHADER_STAGE_GEOMETRY_BIT,
     TessellationControl = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
     TessellationEvaluation = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+    Compute = VK_SHADER_STAGE_COMPUTE_BIT,
   };
 
 private:
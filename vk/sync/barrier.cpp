@@ -0,0 +1,138 @@
+#include "barrier.hpp"
+
+#include "buffers.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+namespace vk {
+namespace {
+auto sameRange(const VkImageSubresourceRange &a,
+               const VkImageSubresourceRange &b) -> bool {
+  return a.aspectMask == b.aspectMask && a.baseMipLevel == b.baseMipLevel &&
+         a.levelCount == b.levelCount && a.baseArrayLayer == b.baseArrayLayer &&
+         a.layerCount == b.layerCount;
+}
+} // namespace
+
+auto BarrierBatch::memory(BarrierScope src, BarrierScope dst)
+    -> BarrierBatch & {
+  if (!m_memory.has_value()) {
+    m_memory = VkMemoryBarrier2{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                .pNext = nullptr,
+                                .srcStageMask = 0,
+                                .srcAccessMask = 0,
+                                .dstStageMask = 0,
+                                .dstAccessMask = 0};
+  }
+
+  m_memory->srcStageMask |= src.stages;
+  m_memory->srcAccessMask |= src.access;
+  m_memory->dstStageMask |= dst.stages;
+  m_memory->dstAccessMask |= dst.access;
+
+  return *this;
+}
+
+auto BarrierBatch::buffer(VkBuffer buffer, BarrierScope src, BarrierScope dst,
+                          VkDeviceSize offset, VkDeviceSize size,
+                          uint32_t srcQueueFamily, uint32_t dstQueueFamily)
+    -> BarrierBatch & {
+  for (auto &barrier : m_buffers) {
+    if (barrier.buffer == buffer && barrier.offset == offset &&
+        barrier.size == size && barrier.srcQueueFamilyIndex == srcQueueFamily &&
+        barrier.dstQueueFamilyIndex == dstQueueFamily) {
+      barrier.srcStageMask |= src.stages;
+      barrier.srcAccessMask |= src.access;
+      barrier.dstStageMask |= dst.stages;
+      barrier.dstAccessMask |= dst.access;
+      return *this;
+    }
+  }
+
+  m_buffers.push_back({.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                       .pNext = nullptr,
+                       .srcStageMask = src.stages,
+                       .srcAccessMask = src.access,
+                       .dstStageMask = dst.stages,
+                       .dstAccessMask = dst.access,
+                       .srcQueueFamilyIndex = srcQueueFamily,
+                       .dstQueueFamilyIndex = dstQueueFamily,
+                       .buffer = buffer,
+                       .offset = offset,
+                       .size = size});
+
+  return *this;
+}
+
+auto BarrierBatch::buffer(Buffer &buffer, BarrierScope src, BarrierScope dst,
+                          VkDeviceSize offset, VkDeviceSize size)
+    -> BarrierBatch & {
+  return this->buffer(*buffer, src, dst, offset, size);
+}
+
+auto BarrierBatch::image(VkImage image, VkImageLayout oldLayout,
+                         VkImageLayout newLayout, BarrierScope src,
+                         BarrierScope dst,
+                         const VkImageSubresourceRange &range,
+                         uint32_t srcQueueFamily, uint32_t dstQueueFamily)
+    -> BarrierBatch & {
+  for (auto &barrier : m_images) {
+    if (barrier.image != image || !sameRange(barrier.subresourceRange, range) ||
+        barrier.srcQueueFamilyIndex != srcQueueFamily ||
+        barrier.dstQueueFamilyIndex != dstQueueFamily) {
+      continue;
+    }
+
+    bool sameTransition =
+        barrier.oldLayout == oldLayout && barrier.newLayout == newLayout;
+    bool chained = barrier.newLayout == oldLayout;
+    if (!sameTransition && !chained) {
+      continue;
+    }
+
+    barrier.newLayout = newLayout;
+    barrier.srcStageMask |= src.stages;
+    barrier.srcAccessMask |= src.access;
+    barrier.dstStageMask |= dst.stages;
+    barrier.dstAccessMask |= dst.access;
+    return *this;
+  }
+
+  m_images.push_back({.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                      .pNext = nullptr,
+                      .srcStageMask = src.stages,
+                      .srcAccessMask = src.access,
+                      .dstStageMask = dst.stages,
+                      .dstAccessMask = dst.access,
+                      .oldLayout = oldLayout,
+                      .newLayout = newLayout,
+                      .srcQueueFamilyIndex = srcQueueFamily,
+                      .dstQueueFamilyIndex = dstQueueFamily,
+                      .image = image,
+                      .subresourceRange = range});
+
+  return *this;
+}
+
+void BarrierBatch::flush(VkCommandBuffer commandBuffer,
+                         VkDependencyFlags dependencyFlags) {
+  if (empty()) {
+    return;
+  }
+
+  VkDependencyInfo info{
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .pNext = nullptr,
+      .dependencyFlags = dependencyFlags,
+      .memoryBarrierCount = m_memory.has_value() ? 1u : 0u,
+      .pMemoryBarriers = m_memory.has_value() ? &m_memory.value() : nullptr,
+      .bufferMemoryBarrierCount = static_cast<uint32_t>(m_buffers.size()),
+      .pBufferMemoryBarriers = m_buffers.data(),
+      .imageMemoryBarrierCount = static_cast<uint32_t>(m_images.size()),
+      .pImageMemoryBarriers = m_images.data()};
+
+  vkCmdPipelineBarrier2(commandBuffer, &info);
+
+  clear();
+}
+} // namespace vk
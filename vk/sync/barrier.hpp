@@ -0,0 +1,69 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace vk {
+class Buffer;
+
+// Source or destination half of a synchronization2 dependency
+struct BarrierScope {
+  VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+  VkAccessFlags2 access = VK_ACCESS_2_NONE;
+};
+
+// Accumulates barriers and issues them in a single vkCmdPipelineBarrier2.
+//
+// Barriers on the same buffer range or image subresource range are merged by
+// OR-ing their masks, and all global memory barriers collapse into one. An
+// image transition queued on top of a pending transition of the same range is
+// folded into a single old -> new layout transition, since nothing can have
+// used the intermediate layout before the batch is flushed.
+//
+// Requires Vulkan 1.3 with `synchronization2` enabled.
+class BarrierBatch {
+  std::optional<VkMemoryBarrier2> m_memory;
+  std::vector<VkBufferMemoryBarrier2> m_buffers;
+  std::vector<VkImageMemoryBarrier2> m_images;
+
+public:
+  [[nodiscard]] auto empty() const -> bool {
+    return !m_memory.has_value() && m_buffers.empty() && m_images.empty();
+  }
+
+  // Number of individual barriers that a flush would issue
+  [[nodiscard]] auto size() const -> size_t {
+    return (m_memory.has_value() ? 1 : 0) + m_buffers.size() + m_images.size();
+  }
+
+  auto memory(BarrierScope src, BarrierScope dst) -> BarrierBatch &;
+
+  auto buffer(VkBuffer buffer, BarrierScope src, BarrierScope dst,
+              VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE,
+              uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED,
+              uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED)
+      -> BarrierBatch &;
+  auto buffer(Buffer &buffer, BarrierScope src, BarrierScope dst,
+              VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE)
+      -> BarrierBatch &;
+
+  auto image(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+             BarrierScope src, BarrierScope dst,
+             const VkImageSubresourceRange &range,
+             uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED,
+             uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED)
+      -> BarrierBatch &;
+
+  // Record the pending barriers, if any, and clear the batch
+  void flush(VkCommandBuffer commandBuffer,
+             VkDependencyFlags dependencyFlags = 0);
+
+  void clear() {
+    m_memory.reset();
+    m_buffers.clear();
+    m_images.clear();
+  }
+};
+} // namespace vk
@@ -0,0 +1,108 @@
+#include "pools.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "device/device.hpp"
+
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace vk {
+FencePool::FencePool(Device &device, size_t preallocate)
+    : m_device(device.ref()) {
+  m_free.reserve(preallocate);
+  for (size_t i = 0; i < preallocate; i++) {
+    auto fence = device.createFence();
+    if (!fence.has_value()) {
+      Logger::error("Failed to preallocate fence");
+      break;
+    }
+    m_free.push_back(std::move(fence.value()));
+    m_created++;
+  }
+}
+
+FencePool::~FencePool() {
+  for (auto &fence : m_free) {
+    fence.release();
+  }
+}
+
+auto FencePool::acquire() -> std::optional<Fence> {
+  {
+    std::scoped_lock lock(m_mutex);
+    if (!m_free.empty()) {
+      auto fence = std::move(m_free.back());
+      m_free.pop_back();
+      return fence;
+    }
+  }
+
+  auto fence = m_device->createFence();
+  if (!fence.has_value()) {
+    Logger::error("Failed to create pooled fence");
+    return std::nullopt;
+  }
+  m_created++;
+  return fence;
+}
+
+void FencePool::release(Fence &&fence) {
+  // Reset outside the lock, it is a driver call
+  fence.reset();
+
+  std::scoped_lock lock(m_mutex);
+  m_free.push_back(std::move(fence));
+}
+
+SemaphorePool::SemaphorePool(Device &device, size_t preallocate)
+    : m_device(device.ref()) {
+  m_free.reserve(preallocate);
+  for (size_t i = 0; i < preallocate; i++) {
+    auto semaphore = device.createSemaphore();
+    if (!semaphore.has_value()) {
+      Logger::error("Failed to preallocate semaphore");
+      break;
+    }
+    m_free.push_back(std::move(semaphore.value()));
+    m_created++;
+  }
+}
+
+SemaphorePool::~SemaphorePool() {
+  for (auto &semaphore : m_free) {
+    semaphore.release();
+  }
+}
+
+auto SemaphorePool::acquire() -> std::optional<Semaphore> {
+  {
+    std::scoped_lock lock(m_mutex);
+    if (!m_free.empty()) {
+      auto semaphore = std::move(m_free.back());
+      m_free.pop_back();
+      return semaphore;
+    }
+  }
+
+  auto semaphore = m_device->createSemaphore();
+  if (!semaphore.has_value()) {
+    Logger::error("Failed to create pooled semaphore");
+    return std::nullopt;
+  }
+  m_created++;
+  return semaphore;
+}
+
+void SemaphorePool::release(Semaphore &&semaphore) {
+  if (semaphore.isTimeline()) {
+    Logger::error("Timeline semaphores cannot be returned to the pool");
+    semaphore.release();
+    return;
+  }
+
+  std::scoped_lock lock(m_mutex);
+  m_free.push_back(std::move(semaphore));
+}
+} // namespace vk
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ref.hpp"
+#include "sync/fence.hpp"
+#include "sync/semaphore.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace vk {
+class Device;
+
+// Recycles unsignalled fences. Safe to use from several threads; the lock is
+// only held to move a fence in or out of the free list.
+class FencePool {
+  RawRef<Device, VkDevice> m_device;
+  std::mutex m_mutex;
+  std::vector<Fence> m_free;
+  std::atomic<size_t> m_created = 0;
+
+public:
+  explicit FencePool(Device &device, size_t preallocate = 0);
+  // Destroys the free fences, ones still handed out are the caller's
+  ~FencePool();
+
+  FencePool(const FencePool &) = delete;
+  auto operator=(const FencePool &) -> FencePool & = delete;
+
+  // An unsignalled fence, created only when the pool is empty
+  auto acquire() -> std::optional<Fence>;
+
+  // Return a fence whose submission has completed, or that was never
+  // submitted. It is reset before it can be handed out again.
+  void release(Fence &&fence);
+
+  // Fences created over the pool's lifetime, to size `preallocate`
+  [[nodiscard]] auto created() const -> size_t { return m_created; }
+};
+
+// Recycles binary semaphores. A semaphore may only be returned once no signal
+// or wait on it is pending, i.e. after the submission waiting on it has
+// completed.
+class SemaphorePool {
+  RawRef<Device, VkDevice> m_device;
+  std::mutex m_mutex;
+  std::vector<Semaphore> m_free;
+  std::atomic<size_t> m_created = 0;
+
+public:
+  explicit SemaphorePool(Device &device, size_t preallocate = 0);
+  ~SemaphorePool();
+
+  SemaphorePool(const SemaphorePool &) = delete;
+  auto operator=(const SemaphorePool &) -> SemaphorePool & = delete;
+
+  auto acquire() -> std::optional<Semaphore>;
+  // Timeline semaphores are destroyed rather than pooled
+  void release(Semaphore &&semaphore);
+
+  [[nodiscard]] auto created() const -> size_t { return m_created; }
+};
+} // namespace vk
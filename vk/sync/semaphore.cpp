@@ -1,5 +1,7 @@
 #include "semaphore.hpp"
 
+#include "util/vk-logger.hpp"
+
 #include <optional>
 #include <vulkan/vulkan_core.h>
 
@@ -7,8 +9,8 @@
 
 namespace vk {
 
-Semaphore::Semaphore(VkSemaphore semaphore, Device &device)
-    : Handle(semaphore), device(device.ref()) {}
+Semaphore::Semaphore(VkSemaphore semaphore, Device &device, bool timeline)
+    : Handle(semaphore), device(device.ref()), m_timeline(timeline) {}
 auto Semaphore::create(Device &device) -> std::optional<Semaphore> {
   info::SemaphoreCreate createInfo{};
 
@@ -24,8 +26,53 @@ auto Semaphore::create(Device &device, info::SemaphoreCreate createInfo)
     return std::nullopt;
   }
 
-  Semaphore sem(semaphore, device);
+  Semaphore sem(semaphore, device, createInfo.isTimeline());
 
   return sem;
 }
+
+auto Semaphore::createTimeline(Device &device, uint64_t initialValue)
+    -> std::optional<Semaphore> {
+  return create(device, info::SemaphoreCreate().timeline(initialValue));
+}
+
+auto Semaphore::value() const -> std::optional<uint64_t> {
+  uint64_t counter = 0;
+  auto result = vkGetSemaphoreCounterValue(device, m_handle, &counter);
+  if (result != VK_SUCCESS) {
+    Logger::error("Failed to read semaphore counter: {}",
+                  static_cast<int>(result));
+    return std::nullopt;
+  }
+  return counter;
+}
+
+auto Semaphore::wait(uint64_t value, uint64_t timeout) const -> bool {
+  VkSemaphoreWaitInfo waitInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                               .pNext = nullptr,
+                               .flags = 0,
+                               .semaphoreCount = 1,
+                               .pSemaphores = &m_handle,
+                               .pValues = &value};
+
+  auto result = vkWaitSemaphores(device, &waitInfo, timeout);
+  if (result != VK_SUCCESS && result != VK_TIMEOUT) {
+    Logger::error("Failed to wait for semaphore: {}",
+                  static_cast<int>(result));
+  }
+  return result == VK_SUCCESS;
+}
+
+void Semaphore::signal(uint64_t value) {
+  VkSemaphoreSignalInfo signalInfo{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+      .pNext = nullptr,
+      .semaphore = m_handle,
+      .value = value};
+
+  auto result = vkSignalSemaphore(device, &signalInfo);
+  if (result != VK_SUCCESS) {
+    Logger::error("Failed to signal semaphore: {}", static_cast<int>(result));
+  }
+}
 } // namespace vk
@@ -3,6 +3,7 @@
 #include "handle.hpp"
 #include "ref.hpp"
 #include "vulkan/vulkan_core.h"
+#include <cstdint>
 #include <optional>
 
 namespace vk {
@@ -13,27 +14,71 @@ namespace vk {
 
 namespace info {
 class SemaphoreCreate : public VkSemaphoreCreateInfo {
+  std::optional<VkSemaphoreTypeCreateInfo> m_type;
+
+  void setupType() { pNext = m_type.has_value() ? &m_type.value() : nullptr; }
 
 public:
   SemaphoreCreate()
       : VkSemaphoreCreateInfo{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
                               .pNext = nullptr,
                               .flags = 0} {}
+
+  // Timeline semaphores require Vulkan 1.2 with `timelineSemaphore` enabled
+  auto timeline(uint64_t initialValue = 0) -> SemaphoreCreate & {
+    m_type = VkSemaphoreTypeCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = initialValue};
+    setupType();
+    return *this;
+  }
+
+  [[nodiscard]] auto isTimeline() const -> bool { return m_type.has_value(); }
+
+  SemaphoreCreate(const SemaphoreCreate &other)
+      : VkSemaphoreCreateInfo{other}, m_type(other.m_type) {
+    setupType();
+  }
+
+  SemaphoreCreate(SemaphoreCreate &&other) noexcept
+      : VkSemaphoreCreateInfo{other}, m_type(other.m_type) {
+    setupType();
+  }
 };
 
 } // namespace info
 
 class Semaphore : public Handle<VkSemaphore> {
   RawRef<Device, VkDevice> device;
+  bool m_timeline;
 
 public:
-  Semaphore(VkSemaphore semaphore, Device &device);
+  Semaphore(VkSemaphore semaphore, Device &device, bool timeline = false);
 
   Semaphore(Semaphore &&other) noexcept = default;
 
   static auto create(Device &device) -> std::optional<Semaphore>;
   static auto create(Device &device, info::SemaphoreCreate info)
       -> std::optional<Semaphore>;
+  static auto createTimeline(Device &device, uint64_t initialValue = 0)
+      -> std::optional<Semaphore>;
+
+  [[nodiscard]] auto isTimeline() const -> bool { return m_timeline; }
+
+  // Current counter of a timeline semaphore, nullopt if it could not be read,
+  // e.g. after device loss
+  [[nodiscard]] auto value() const -> std::optional<uint64_t>;
+
+  // Block until a timeline semaphore reaches `value`. Returns false on
+  // timeout or error.
+  [[nodiscard]] auto wait(uint64_t value, uint64_t timeout = UINT64_MAX) const
+      -> bool;
+
+  // Set a timeline semaphore to `value` from the host. It must be greater
+  // than the current value and any pending signal.
+  void signal(uint64_t value);
 
   auto destroy() -> void override {
     vkDestroySemaphore(device, m_handle, nullptr);
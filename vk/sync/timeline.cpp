@@ -0,0 +1,19 @@
+#include "timeline.hpp"
+
+#include "util/vk-logger.hpp"
+
+#include "device/device.hpp"
+
+#include <optional>
+
+namespace vk {
+auto QueueTimeline::create(Device &device) -> std::optional<QueueTimeline> {
+  auto semaphore = device.createTimelineSemaphore();
+  if (!semaphore.has_value()) {
+    Logger::error("Failed to create queue timeline semaphore");
+    return std::nullopt;
+  }
+
+  return QueueTimeline(std::move(semaphore.value()));
+}
+} // namespace vk
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "queue.hpp"
+#include "sync/semaphore.hpp"
+
+#include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+
+namespace vk {
+class Device;
+
+// One monotonically increasing timeline per queue. Every submission signals
+// the next value, so "has submission N finished" is a single comparison and
+// the value doubles as the lifetime token for anything the submission uses.
+class QueueTimeline {
+  Semaphore m_semaphore;
+  uint64_t m_submitted = 0;
+  // Highest value given up through `skip`
+  uint64_t m_skipped = 0;
+  // Last counter value read, kept when reading fails
+  mutable uint64_t m_completed = 0;
+
+  explicit QueueTimeline(Semaphore &&semaphore)
+      : m_semaphore(std::move(semaphore)) {}
+
+public:
+  static auto create(Device &device) -> std::optional<QueueTimeline>;
+
+  QueueTimeline(QueueTimeline &&other) noexcept = default;
+
+  [[nodiscard]] auto semaphore() const -> const Semaphore & {
+    return m_semaphore;
+  }
+
+  // Value the next submission should signal
+  [[nodiscard]] auto next() const -> uint64_t {
+    return std::max(m_submitted, m_skipped) + 1;
+  }
+
+  // Last value handed out to a submission
+  [[nodiscard]] auto submitted() const -> uint64_t { return m_submitted; }
+
+  // Never ahead of the GPU: if the counter cannot be read the last value
+  // read is returned
+  [[nodiscard]] auto completed() const -> uint64_t {
+    if (auto value = m_semaphore.value(); value.has_value()) {
+      m_completed = value.value();
+    }
+    return m_completed;
+  }
+
+  [[nodiscard]] auto isComplete(uint64_t value) const -> bool {
+    return value <= m_submitted && completed() >= value;
+  }
+
+  // Make `submit` signal `value`, which must be past `submitted()`, without
+  // counting it as submitted yet. Call `commit` once the submit succeeded;
+  // if it fails the value is simply never committed.
+  void addSignal(info::Submit &submit, uint64_t value) const {
+    assert(value > m_submitted);
+    submit.addSignalSemaphore(m_semaphore, value);
+  }
+
+  void addSignal(info::Submit2 &submit, uint64_t value) const {
+    assert(value > m_submitted);
+    submit.addSignalSemaphore(m_semaphore, value);
+  }
+
+  // Record a successful submit signalling `value`
+  void commit(uint64_t value) {
+    assert(value > m_submitted);
+    m_submitted = value;
+  }
+
+  // Never hand out `value` again, e.g. after it was promised for work that
+  // failed to submit. Waits on it still complete once a later value is
+  // signalled, so whoever was promised it has to learn of the failure some
+  // other way.
+  void skip(uint64_t value) {
+    assert(value > m_submitted);
+    m_skipped = std::max(m_skipped, value);
+  }
+
+  // Make `submit` wait for `value` at `stages`
+  void addWait(info::Submit &submit, uint64_t value,
+               VkPipelineStageFlags stages) const {
+    submit.addWaitSemaphore(m_semaphore, stages, value);
+  }
+
+  void addWait(info::Submit2 &submit, uint64_t value,
+               VkPipelineStageFlags2 stages) const {
+    submit.addWaitSemaphore(m_semaphore, stages, value);
+  }
+
+  [[nodiscard]] auto wait(uint64_t value, uint64_t timeout = UINT64_MAX) const
+      -> bool {
+    return m_semaphore.wait(value, timeout);
+  }
+
+  // Block until everything submitted so far has completed
+  [[nodiscard]] auto waitIdle(uint64_t timeout = UINT64_MAX) const -> bool {
+    return wait(m_submitted, timeout);
+  }
+};
+} // namespace vk
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace vk {
+class Versioned;
+
+// A weak view of a `Versioned` object's version, taken when something was
+// recorded against it. It is stale once the object is destroyed or changes.
+class VersionSnapshot {
+  std::weak_ptr<const uint64_t> m_version;
+  uint64_t m_seen;
+
+public:
+  explicit VersionSnapshot(const Versioned &object);
+
+  [[nodiscard]] auto isCurrent() const -> bool {
+    auto version = m_version.lock();
+    return version != nullptr && *version == m_seen;
+  }
+};
+
+// Change counter shared by every copy of an object. Moving hands the counter
+// to the new object, and destroying or releasing the last owner expires all
+// snapshots.
+class Versioned {
+  std::shared_ptr<uint64_t> m_version = std::make_shared<uint64_t>(0);
+
+  friend class VersionSnapshot;
+
+public:
+  Versioned() = default;
+  Versioned(const Versioned &) = default;
+  auto operator=(const Versioned &) -> Versioned & = default;
+  Versioned(Versioned &&o) noexcept = default;
+  auto operator=(Versioned &&o) noexcept -> Versioned & = default;
+
+  [[nodiscard]] auto version() const -> uint64_t {
+    return m_version ? *m_version : 0;
+  }
+
+protected:
+  // Invalidate snapshots taken before a change that affects recorded work
+  void bumpVersion() {
+    if (m_version) {
+      (*m_version)++;
+    }
+  }
+
+  // Invalidate every snapshot for good, for objects released before their
+  // destructor runs
+  void expireVersion() {
+    bumpVersion();
+    m_version.reset();
+  }
+};
+
+inline VersionSnapshot::VersionSnapshot(const Versioned &object)
+    : m_version(object.m_version), m_seen(object.version()) {}
+} // namespace vk